@@ -0,0 +1,59 @@
+#ifndef ASYNC_NET_H
+#define ASYNC_NET_H
+
+#include <Arduino.h>
+#include <esp_err.h>
+#include <functional>
+
+// Number of worker tasks (i.e. how many jobs can be in flight at once)
+#ifndef ASYNC_NET_WORKERS
+#define ASYNC_NET_WORKERS 3
+#endif
+
+// Pending jobs that can be queued before submit() fails
+#ifndef ASYNC_NET_QUEUE_DEPTH
+#define ASYNC_NET_QUEUE_DEPTH 8
+#endif
+
+// Worker stack size; TLS handshakes need a deep stack
+#ifndef ASYNC_NET_STACK_SIZE
+#define ASYNC_NET_STACK_SIZE 12288
+#endif
+
+// Runs blocking network work (HTTP requests, SNTP, MQTT connect) on a pool
+// of FreeRTOS worker tasks so independent requests overlap instead of
+// running back to back in setup().
+namespace AsyncNet {
+// A unit of work; the return value is handed back through await()
+typedef std::function<esp_err_t()> Job;
+
+// Opaque handle to a submitted job
+struct Request;
+typedef Request *Handle;
+
+// Start the worker tasks (safe to call more than once)
+bool begin();
+
+// Queue a job. If the pool can't take it, the job runs inline and the
+// returned handle is already finished.
+Handle submit(const char *name, Job job);
+
+// True once the job has finished (nullptr counts as finished)
+bool poll(Handle handle);
+
+// Wait for the job to finish; returns its result, or ESP_ERR_TIMEOUT if it
+// is still running after timeoutMs
+esp_err_t await(Handle handle, unsigned long timeoutMs);
+
+// Release the handle. A job that is still running frees itself when done,
+// so anything it captured must outlive it.
+void release(Handle handle);
+
+// Convenience: await() + release()
+esp_err_t finish(Handle handle, unsigned long timeoutMs);
+
+// Wall time the job spent running (0 if it hasn't finished)
+unsigned long elapsed(Handle handle);
+} // namespace AsyncNet
+
+#endif
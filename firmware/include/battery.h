@@ -9,4 +9,8 @@ extern const float voltageTable[11][2];
 // Calculate the battery percentage based on the given voltage
 int getBatteryPercentage(float voltage);
 
+// Estimate the remaining charge (0.0 - 1.0) based on the given voltage,
+// interpolating between the table's entries
+float getBatteryCharge(float voltage);
+
 #endif
@@ -0,0 +1,45 @@
+#ifndef BATTERY_HISTORY_H
+#define BATTERY_HISTORY_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// Wakes remembered across deep sleep (8 bytes each)
+#ifndef BATTERY_HISTORY_SIZE
+#define BATTERY_HISTORY_SIZE 48
+#endif
+
+// Wakes needed before the discharge rate is trusted
+#ifndef BATTERY_HISTORY_MIN
+#define BATTERY_HISTORY_MIN 12
+#endif
+
+// A voltage rise this large (V) between wakes means the battery was charged
+#ifndef BATTERY_CHARGE_JUMP
+#define BATTERY_CHARGE_JUMP 0.1f
+#endif
+
+// Longest interval the budget stretches interval wakes to (seconds)
+#ifndef BATTERY_MAX_INTERVAL
+#define BATTERY_MAX_INTERVAL 86400
+#endif
+
+// Discharge history for battery-adaptive scheduling. Each wake records the
+// battery voltage (read before the radio starts) and the time in an RTC
+// ring. A least-squares fit of the charge over the wakes since the last
+// charge gives the cost of one wake, sleep current included, and from that
+// the number of wakes the battery has left. When those won't stretch to
+// renderer.minruntime after the charge, interval wakes are spaced out;
+// scheduled wakes are always kept.
+namespace BatteryHistory {
+// Record this wake's battery voltage. A jump up starts a new history.
+void record(time_t now, float voltage);
+
+// Shortest interval between interval wakes that makes the battery last
+// 'runtime' seconds from the last charge, given 'scheduledPerDay' wakes a
+// day that are kept regardless. 0 if the battery will last anyway, or
+// there isn't enough history to tell.
+uint32_t intervalFloor(time_t now, uint32_t runtime, size_t scheduledPerDay);
+} // namespace BatteryHistory
+
+#endif
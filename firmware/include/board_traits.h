@@ -0,0 +1,95 @@
+#ifndef BOARD_TRAITS_H
+#define BOARD_TRAITS_H
+
+// What this build can display and decode, fixed at compile time. Sent to the
+// renderer (X-Inky-Caps) so it can pick a payload the device handles cheaply.
+
+#ifdef ARDUINO_INKPLATE10V2
+#define BOARD_PANEL "inkplate10"
+#define BOARD_BPP 3
+#define BOARD_PALETTE "gray8"
+#endif
+
+#ifdef ARDUINO_INKPLATECOLOR
+#define BOARD_PANEL "inkplate6color"
+#define BOARD_BPP 3
+#define BOARD_PALETTE "color7"
+#endif
+
+#ifndef BOARD_PANEL
+#define BOARD_PANEL "unknown"
+#define BOARD_BPP 1
+#define BOARD_PALETTE "mono"
+#endif
+
+// Image formats the firmware renders (progressive JPEGs are converted to
+// baseline on the device, which costs time and PSRAM)
+#ifndef BOARD_DECODERS
+#define BOARD_DECODERS "jpeg,pjpeg"
+#endif
+
+// Largest image body accepted (2MB); leaves headroom in PSRAM for the
+// conversion. Kept a plain literal so it can be stringified.
+#ifndef BOARD_MAX_BODY
+#define BOARD_MAX_BODY 2097152
+#endif
+
+// Current model for the energy estimate (Energy) and
+// tools/battery_sim.mjs. These are typical figures for a stock board
+// running on battery; measure a board and override them with build flags
+// to calibrate.
+#ifdef ARDUINO_INKPLATECOLOR
+// The 6COLOR panel refreshes for much longer, at a lower current, and ships
+// with a smaller cell
+#ifndef BOARD_BATTERY_MAH
+#define BOARD_BATTERY_MAH 1200
+#endif
+#ifndef BOARD_REFRESH_MA
+#define BOARD_REFRESH_MA 20
+#endif
+#endif
+
+// Battery capacity (mAh)
+#ifndef BOARD_BATTERY_MAH
+#define BOARD_BATTERY_MAH 3000
+#endif
+
+// Deep sleep current, RTC running (uA)
+#ifndef BOARD_SLEEP_UA
+#define BOARD_SLEEP_UA 18
+#endif
+
+// Awake with the radio off: a base current plus a share per MHz of CPU
+// clock (mA)
+#ifndef BOARD_CPU_BASE_MA
+#define BOARD_CPU_BASE_MA 22
+#endif
+#ifndef BOARD_CPU_MA_PER_MHZ
+#define BOARD_CPU_MA_PER_MHZ 0.12
+#endif
+
+// Added while WiFi is on (mA)
+#ifndef BOARD_RADIO_MA
+#define BOARD_RADIO_MA 85
+#endif
+
+// Added during a panel refresh (mA)
+#ifndef BOARD_REFRESH_MA
+#define BOARD_REFRESH_MA 45
+#endif
+
+// Added per KB sent or received, for the transmit bursts (uAh)
+#ifndef BOARD_UAH_PER_KB
+#define BOARD_UAH_PER_KB 0.05
+#endif
+
+#define BOARD_STR_(x) #x
+#define BOARD_STR(x) BOARD_STR_(x)
+
+// Static part of the capability descriptor; free PSRAM, battery and rotation
+// are appended at request time
+#define BOARD_CAPS                                                             \
+  "panel=" BOARD_PANEL ";bpp=" BOARD_STR(BOARD_BPP) ";pal=" BOARD_PALETTE   \
+      ";dec=" BOARD_DECODERS ";max=" BOARD_STR(BOARD_MAX_BODY)
+
+#endif
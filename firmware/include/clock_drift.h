@@ -0,0 +1,72 @@
+#ifndef CLOCK_DRIFT_H
+#define CLOCK_DRIFT_H
+
+#include <Arduino.h>
+#include <Inkplate.h>
+#include <sys/time.h>
+
+#include "config_snapshot.h"
+
+// Drift assumed before two syncs have measured it (ppm; a typical 32kHz
+// crystal is within +/-20 ppm at room temperature)
+#ifndef CLOCK_DRIFT_DEFAULT_PPM
+#define CLOCK_DRIFT_DEFAULT_PPM 50.0f
+#endif
+
+// Shortest gap between syncs that counts as a drift measurement (6 hours);
+// the RTC only reads whole seconds, so shorter spans are mostly noise
+#ifndef CLOCK_DRIFT_MIN_SPAN
+#define CLOCK_DRIFT_MIN_SPAN 21600
+#endif
+
+// Error (seconds) the RTC starts with after a sync: reading it to the second
+// and writing it on a second boundary
+#ifndef CLOCK_DRIFT_BASE_ERROR
+#define CLOCK_DRIFT_BASE_ERROR 1.0f
+#endif
+
+// Set to 0 to keep the RTC_OFFSET_MODE / RTC_OFFSET_VALUE trim instead of
+// retuning the RTC from the measured drift
+#ifndef CLOCK_DRIFT_AUTO_TRIM
+#define CLOCK_DRIFT_AUTO_TRIM 1
+#endif
+
+// How long a timezone rule from the API is reused (30 days). The rule
+// carries the DST transitions, so this only picks up changes to the zone
+// itself.
+#ifndef CLOCK_TZ_RULE_TTL
+#define CLOCK_TZ_RULE_TTL 2592000
+#endif
+
+// Models the drift of the Inkplate's RTC from successive NTP syncs, kept in
+// RTC memory, so NTP only runs when the predicted error could exceed
+// ntp.maxerror. The measured drift is also trimmed out through the RTC's
+// offset register (PCF85063, 4.34 ppm steps), starting from the build's
+// RTC_OFFSET_MODE / RTC_OFFSET_VALUE calibration.
+namespace ClockDrift {
+// Apply the RTC trim and, if the RTC is set, restore the system clock and
+// timezone from it (call once the RTC has been read)
+void begin(Inkplate &display);
+
+// True if NTP should run: no sync recorded, the RTC is unset, the last sync
+// is older than ntp.maxinterval, or the predicted error is above
+// ntp.maxerror
+bool syncDue(Inkplate &display, const AppConfig::Ntp &ntp);
+
+// Remember the POSIX TZ rule NTPFetch applied, for wakes that skip it.
+// 'zone' is the timezone it was looked up for ("" if it came from the
+// config), 'now' the time of the lookup.
+void setTimezone(const char *rule, const char *zone, time_t now);
+
+// The remembered rule if it was looked up for 'zone' less than 'maxAge'
+// seconds before 'now', else nullptr
+const char *timezoneRule(const char *zone, time_t now, uint32_t maxAge);
+
+// Record a sync. 'rtcBefore' is what the RTC read at 'ntpNow' (0 if it
+// was unset); 'written' is the epoch the RTC was then set to. Reapplies
+// the trim, since setting the RTC resets it.
+void recordSync(Inkplate &display, time_t rtcBefore,
+                const struct timeval &ntpNow, time_t written);
+} // namespace ClockDrift
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef CONFIG_SNAPSHOT_H
+#define CONFIG_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <esp_err.h>
+
+#ifndef CONFIG_SNAPSHOT_PATH
+#define CONFIG_SNAPSHOT_PATH "/config.bin"
+#endif
+
+// Bump whenever AppConfig changes shape (the struct size is checked too)
+#define CONFIG_SNAPSHOT_VERSION 5
+
+// Scheduled wakes kept from renderer.wakes
+#ifndef CONFIG_MAX_WAKES
+#define CONFIG_MAX_WAKES 256
+#endif
+
+// Space for every string in the config (URLs, endpoints, credentials)
+#ifndef CONFIG_STRING_POOL
+#define CONFIG_STRING_POOL 16384
+#endif
+
+// Largest config.json accepted
+#ifndef CONFIG_MAX_SOURCE
+#define CONFIG_MAX_SOURCE 32768
+#endif
+
+// One entry of renderer.wakes
+struct WakeSlot {
+  const char *time;     // e.g. "10:30am"
+  const char *endpoint; // e.g. "/render/news"
+};
+
+// Everything the firmware reads from config.json, with defaults applied.
+// Built from the JSON once, then saved to CONFIG_SNAPSHOT_PATH as is:
+// strings live in 'pool' and are stored as offsets, so loading the snapshot
+// is a file read and a pointer fix-up rather than a JSON parse.
+struct AppConfig {
+  // Header
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;       // sizeof(AppConfig)
+  uint32_t sourceCrc;  // CRC32 of the config.json it was built from
+  uint32_t sourceSize; // Size of that file
+  uint32_t crc;        // CRC32 of everything after this field
+  uint32_t poolUsed;
+
+  const char *api;
+  const char *configVersion;
+
+  struct Security {
+    bool allowInsecure;
+    const char *caCertPath;
+  } security;
+
+  struct Mqtt {
+    bool enabled;
+    bool tls;
+    bool trace; // Publish the wake timeline to <topic>/trace
+    uint16_t port;
+    int retries;
+    int maxtx;
+    int maxrx;
+    const char *server;
+    const char *user;
+    const char *pass;
+    const char *device;
+    const char *topic;
+  } mqtt;
+
+  struct Ntp {
+    bool enabled;
+    int retries;
+    int gmtOffset;
+    int daylightOffset;
+    uint32_t maxError;    // Resync once the RTC may be this far off (s)
+    uint32_t maxInterval; // ...or this long after the last sync (s)
+    const char *server1;
+    const char *server2;
+    const char *timezone;
+    const char *basepath;
+    const char *posix; // POSIX TZ rule; skips the timezone lookup if set
+  } ntp;
+
+  struct Renderer {
+    bool cleardisplay;
+    bool compression;
+    bool prefetch;
+    bool framecache;
+    bool offlineRotate; // offline: "rotate" (true) or "last"
+    int retries;
+    int timeout;
+    uint32_t readsize;
+    uint32_t prefetchMaxAge;
+    uint32_t maxDefer;
+    const char *basepath;
+    const char *defaultEndpoint; // "default", nullptr if unset
+    const char *button;          // nullptr if unset
+    const char *sleepStart;
+    const char *sleepStop;
+    const char *interval;   // "wake-interval"
+    const char *minRuntime; // Battery should last this long ("30d")
+    uint16_t wakeCount;
+    WakeSlot wakes[CONFIG_MAX_WAKES];
+  } renderer;
+
+  char pool[CONFIG_STRING_POOL];
+};
+
+namespace ConfigSnapshot {
+// Load 'path' into a newly allocated (PSRAM) AppConfig. Uses the snapshot
+// when it was built from the same file; otherwise parses the JSON and
+// writes a new snapshot. ESP_ERR_NOT_FOUND: missing/empty file,
+// ESP_ERR_INVALID_ARG: unparseable JSON, ESP_ERR_NO_MEM: too large.
+esp_err_t load(const char *path, AppConfig *&config);
+} // namespace ConfigSnapshot
+
+#endif
@@ -43,4 +43,13 @@
 
 #define uS_TO_S_FACTOR 1000000UL
 
+// Deadlines (ms) for the deep sleep shutdown: logs reaching the broker, and
+// the AP acknowledging the disconnect
+#ifndef SHUTDOWN_MQTT_TIMEOUT
+#define SHUTDOWN_MQTT_TIMEOUT 3000
+#endif
+#ifndef SHUTDOWN_WIFI_TIMEOUT
+#define SHUTDOWN_WIFI_TIMEOUT 500
+#endif
+
 #endif
@@ -0,0 +1,56 @@
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <IPAddress.h>
+
+// Hostnames remembered across deep sleep
+#ifndef DNS_CACHE_ENTRIES
+#define DNS_CACHE_ENTRIES 6
+#endif
+
+// Longest hostname that is cached (longer names are always looked up)
+#ifndef DNS_CACHE_HOST_LEN
+#define DNS_CACHE_HOST_LEN 48
+#endif
+
+// How long a lookup is trusted, in seconds. lwIP doesn't hand the record TTL
+// to callers, so every entry gets this lifetime. It should outlast the
+// longest usual gap between wakes (overnight); an address that moves sooner
+// is caught when it stops answering.
+#ifndef DNS_CACHE_TTL
+#define DNS_CACHE_TTL 43200
+#endif
+
+// Time the next wake is given to make its lookups, when deciding what to
+// refresh (seconds)
+#ifndef DNS_CACHE_MARGIN
+#define DNS_CACHE_MARGIN 300
+#endif
+
+// Resolver cache kept in RTC memory, so a wake can skip the DNS round trips
+// for the API host, MQTT broker and NTP servers. Entries are timed with the
+// system clock, which keeps running through deep sleep.
+namespace DNSCache {
+// Resolve a hostname (or IP literal), from the cache when possible
+bool resolve(const char *host, IPAddress &ip);
+
+// Forget a hostname, e.g. after its cached address refused a connection
+void invalidate(const char *host);
+
+// Re-resolve entries that would expire before 'nextWake' (epoch) plus
+// DNS_CACHE_MARGIN, so the next wake still hits the cache. Blocking; meant
+// to run as a background job.
+void refresh(time_t nextWake);
+
+// SimpleHTTP connectors: connect using the cached address, retrying with a
+// fresh lookup if that fails. The secure one keeps the hostname for SNI and
+// certificate checks. 'resolvedAt' gets millis() after the lookup.
+bool connect(Client &client, const char *host, uint16_t port,
+             unsigned long &resolvedAt);
+bool connectSecure(Client &client, const char *host, uint16_t port,
+                   unsigned long &resolvedAt);
+} // namespace DNSCache
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <Arduino.h>
+
+// Wakes remembered across deep sleep (for wakes without MQTT)
+#ifndef ENERGY_RING_SIZE
+#define ENERGY_RING_SIZE 16
+#endif
+
+// Per-wake energy accounting. A wake's awake time, the time WiFi was on,
+// panel refreshes, bytes over WiFi and the CPU clock are combined with the
+// board's current model (board_traits.h) into an estimated charge, plus the
+// deep sleep that follows. The record is closed just before deep sleep, so it
+// is kept in an RTC ring and logged as one "Energy:" line (reaching MQTT
+// through the logger) on the next connected wake.
+namespace Energy {
+// Start a new wake (call once, early in setup)
+void begin();
+
+// The radio was turned on or off
+void radio(bool on);
+
+// A panel refresh took 'ms' milliseconds
+void refresh(uint32_t ms);
+
+// The CPU clock changed to 'mhz'
+void cpuFrequency(uint32_t mhz);
+
+// Bytes sent and received by a request
+void addBytes(uint32_t sent, uint32_t received);
+
+// Close this wake's record, to be followed by 'sleepSeconds' of deep sleep
+// (0 if unknown), and keep it in the ring
+void finish(uint32_t sleepSeconds);
+
+// Log records from earlier wakes that weren't published. Call once MQTT is
+// connected.
+void publishBacklog();
+} // namespace Energy
+
+#endif
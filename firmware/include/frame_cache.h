@@ -0,0 +1,43 @@
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include <Arduino.h>
+#include <Inkplate.h>
+
+// Frames kept on LittleFS
+#ifndef FRAME_CACHE_ENTRIES
+#define FRAME_CACHE_ENTRIES 4
+#endif
+
+// Flash budget for all cached frames (compressed), in bytes
+#ifndef FRAME_CACHE_MAX_BYTES
+#define FRAME_CACHE_MAX_BYTES (64 * 1024)
+#endif
+
+// Free space to leave on LittleFS after storing a frame
+#ifndef FRAME_CACHE_FS_RESERVE
+#define FRAME_CACHE_FS_RESERVE (16 * 1024)
+#endif
+
+#ifndef FRAME_CACHE_INDEX_PATH
+#define FRAME_CACHE_INDEX_PATH "/frames.json"
+#endif
+
+// Size of the panel-native frame buffer (3-bit pixels packed two per byte)
+#define FRAME_CACHE_FRAME_BYTES (E_INK_WIDTH * E_INK_HEIGHT / 2)
+
+// Copies of recently rendered frames, so a wake that can't fetch (WiFi or
+// server down) can still put an image up without running the decoder again.
+// Frames are stored straight from the display buffer, PackBits compressed,
+// and evicted least recently used first.
+namespace FrameCache {
+// Save the frame buffer as the image rendered for 'endpoint'. Call after
+// rendering and before any overlays are drawn.
+bool store(Inkplate &display, const char *endpoint, int rotation);
+
+// Load a cached frame into the frame buffer. 'rotate' picks the least
+// recently shown frame (cycling through the cache) rather than the newest.
+bool show(Inkplate &display, int rotation, bool rotate);
+} // namespace FrameCache
+
+#endif
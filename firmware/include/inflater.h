@@ -0,0 +1,102 @@
+#ifndef INFLATER_H
+#define INFLATER_H
+
+#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
+
+#include "psram_allocator.h"
+
+// Streaming decompressor for gzip / deflate HTTP bodies. Uses the ROM
+// inflate routines with the 32KB window and decompressor state in PSRAM, so
+// compressed data can be fed as it arrives off the socket.
+class Inflater {
+public:
+  // Supported Content-Encoding formats
+  enum class Format : uint8_t { GZIP, DEFLATE };
+
+  // Receives decompressed output
+  typedef void (*Sink)(void *ctx, const uint8_t *data, size_t len);
+
+  Inflater();
+  ~Inflater();
+
+  // Owns its buffers; not copyable
+  Inflater(const Inflater &) = delete;
+  Inflater &operator=(const Inflater &) = delete;
+
+  // Map a Content-Encoding header value to a format; false if unsupported
+  static bool formatFor(const String &contentEncoding, Format &format);
+
+  // Allocate the window and reset state; false if out of memory
+  bool begin(Format format);
+
+  // Release the window and decompressor state
+  void end();
+
+  // Whether begin() succeeded and end() hasn't been called
+  bool active() const { return _state != nullptr; }
+
+  // Decompress 'len' bytes of input, passing output to 'sink'
+  // Returns false if the stream is corrupt
+  bool write(const uint8_t *data, size_t len, Sink sink, void *ctx);
+
+  // Decompress 'len' bytes of input, appending output to 'out'
+  bool write(const uint8_t *data, size_t len, PsramVector &out);
+
+  // True once the end of the compressed stream (and gzip trailer) was seen
+  bool finished() const { return _stage == Stage::DONE; }
+
+  // Bytes consumed / produced so far
+  size_t totalIn() const { return _totalIn; }
+  size_t totalOut() const { return _totalOut; }
+
+private:
+  // Parsing stages; gzip wraps the deflate data in a header and trailer
+  enum class Stage : uint8_t {
+    GZIP_HEADER,
+    GZIP_XLEN,
+    GZIP_EXTRA,
+    GZIP_NAME,
+    GZIP_COMMENT,
+    GZIP_HCRC,
+    DEFLATE_PROBE,
+    BODY,
+    GZIP_TRAILER,
+    DONE,
+    FAILED
+  };
+
+  // Consume gzip header/trailer or zlib probe bytes; returns bytes used
+  size_t consumeFraming(const uint8_t *data, size_t len);
+
+  // Move to the next optional gzip header field (or the body)
+  void advanceHeader();
+
+  // Run the decompressor over body bytes; returns bytes used or -1 on error
+  int inflateBody(const uint8_t *data, size_t len, Sink sink, void *ctx);
+
+  // Move trailer bytes tinfl read ahead into the framing scratch
+  void takeReadAhead();
+
+  // Check the complete gzip trailer; moves to DONE or FAILED
+  void checkTrailer();
+
+  void *_state;     // tinfl_decompressor (PSRAM)
+  uint8_t *_window; // 32KB LZ dictionary (PSRAM)
+  size_t _windowPos;
+  uint32_t _flags;
+  Format _format;
+  Stage _stage;
+
+  // Framing scratch
+  uint8_t _frame[10];
+  size_t _frameLen;
+  uint8_t _gzipFlags;
+  size_t _skip;
+
+  size_t _totalIn;
+  size_t _totalOut;
+};
+
+#endif
@@ -3,11 +3,22 @@
 
 #include <Inkplate.h>
 #include <PubSubClient.h>
+#include <functional>
 
 #ifndef LOG_LEVEL
 #define LOG_LEVEL LOG_DEBUG
 #endif
 
+// Wakes that skip waiting for the broker's echo after it was missed once
+#ifndef LOG_SYNC_RETRY
+#define LOG_SYNC_RETRY 24
+#endif
+
+// RTC memory kept for log lines made after MQTT was shut down (bytes)
+#ifndef LOG_RTC_BUFFER
+#define LOG_RTC_BUFFER 1024
+#endif
+
 namespace Logger {
 // Available log levels. Order is important here; higher levels are more serious
 enum LogLevel {
@@ -21,18 +32,44 @@ enum LogLevel {
 
 // Initialize the logger by specifying the Stream to write logs to and the
 // Inkplate display used for showing messages on the screen
+// The RTC is read once here; later timestamps are derived from millis() so
+// logging never touches I2C and is safe from any task
 void init(Stream &s, Inkplate &d);
 
+// Update the timestamp base after the RTC has been (re)set
+void syncClock(time_t epoch);
+
 // MQTT-specific APIs
 void setMQTTClient(PubSubClient &client, const char *topic);
 void flushMQTT();
 
+// Mark whether the MQTT client is connected and safe to publish from the
+// logger. Messages are queued (not sent) until this is set.
+void setMQTTConnected(bool connected);
+
+// True while the logger is publishing to MQTT
+bool isMQTTConnected();
+
+// Publish a payload too large for the MQTT buffer to the log topic followed
+// by 'suffix'. 'write' is called twice (to measure, then to send) and must
+// produce the same bytes both times. False if MQTT isn't connected.
+bool publishStream(const char *suffix,
+                   const std::function<void(Print &)> &write);
+
 // Wait until the queue is flushed or timeout
 void waitForFlush(unsigned long timeoutMs);
 
-// Cleanup: flush logs and disconnect MQTT
+// Cleanup: flush logs, wait for the broker to echo a marker (so the logs
+// made it) and disconnect MQTT. timeoutMs bounds the whole sequence. A
+// missed echo (e.g. the broker won't let us subscribe) skips the wait for
+// the next LOG_SYNC_RETRY wakes. Lines still queued, and any logged
+// afterwards, are kept in RTC memory.
 void cleanup(unsigned long timeoutMs = 5000);
 
+// Publish the lines kept in RTC memory by the last wake. Call once MQTT is
+// connected.
+void publishBacklog();
+
 // Logs a message with a specified log level
 void log(LogLevel level, const char *message);
 
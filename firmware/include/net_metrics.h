@@ -0,0 +1,28 @@
+#ifndef NET_METRICS_H
+#define NET_METRICS_H
+
+#include <Arduino.h>
+
+#include "simplehttp.h"
+
+// Requests remembered across deep sleep (for wakes without MQTT)
+#ifndef NET_METRICS_RING_SIZE
+#define NET_METRICS_RING_SIZE 8
+#endif
+
+// Per-request network timings. Each record is logged as one "Net:" line
+// (so it reaches MQTT through the logger) and kept in an RTC ring; records
+// that never made it to MQTT are re-sent on the next connected wake.
+namespace NetMetrics {
+// Start a new wake (call once, early in setup)
+void begin();
+
+// Record and log the phases of a finished (or failed) request
+void record(const char *label, int code, const SimpleHTTP::Timing &timing);
+
+// Log records from earlier wakes that weren't published. Call once MQTT is
+// connected.
+void publishBacklog();
+} // namespace NetMetrics
+
+#endif
@@ -5,28 +5,105 @@
 #include <Inkplate.h>
 #include <PubSubClient.h>
 #include <esp_err.h>
+#include "config_snapshot.h"
+#include "inflater.h"
 #include "psram_allocator.h"
 
+// Largest span readStream() asks the client for in one call (a full TLS
+// record is 16KB)
+#ifndef READSTREAM_READ_SIZE
+#define READSTREAM_READ_SIZE 8192
+#endif
+
+// Deadline for joining the saved network before WiFiManager takes over
+#ifndef WIFI_CONNECT_TIMEOUT
+#define WIFI_CONNECT_TIMEOUT 10000UL
+#endif
+
+// How long to wait on the cached AP/lease before doing a full connect
+#ifndef WIFI_FAST_CONNECT_TIMEOUT
+#define WIFI_FAST_CONNECT_TIMEOUT 4000UL
+#endif
+
+// Wakes a cached DHCP lease is reused for before asking the server again
+#ifndef WIFI_LEASE_REUSE_MAX
+#define WIFI_LEASE_REUSE_MAX 24
+#endif
+
 // Global network clients
 extern WiFiClient wifiClient;
 extern WiFiClientSecure wifiClientSecure;
 extern PubSubClient mqttClient;
 
-// Connects to WiFi or launches the captive portal if connection fails
+// Starts joining the saved network in the background (cached AP, channel and
+// lease first). Call as early as possible; ESP_ERR_NOT_FOUND means there are
+// no saved credentials.
+esp_err_t WifiBegin();
+
+// Blocks until the link started by WifiBegin() has an IP (starting it if
+// needed), falling back to a normal scan + DHCP. The deadline counts from
+// WifiBegin(), so local setup done in between is free.
+esp_err_t WifiWaitReady(unsigned long timeoutMs);
+
+// Disconnects from the AP (waiting up to timeoutMs for the disconnect event,
+// so the deauth is sent) and turns the radio off
+esp_err_t WifiShutdown(unsigned long timeoutMs);
+
+// Connects to WiFi or launches the captive portal if connection fails. The
+// saved network is joined directly (cached AP, channel and lease first);
+// WiFiManager only runs if that fails or forceConfig is set.
 esp_err_t WifiConnect(Inkplate &display, int timeoutSeconds,
                       bool forceConfig = false);
 
 // Connects to the MQTT broker using the provided configuration
-esp_err_t MqttConnect(const JsonVariant &mqttConfig);
+esp_err_t MqttConnect(const AppConfig::Mqtt &mqttConfig);
+
+// Image bytes plus the render hints sent along with them
+struct FetchedImage {
+  PsramVector data;
+  bool noDithering = false;
+  String messages[3]; // X-Inky-Message-0..2 (top, middle, bottom)
+
+  // Scheduling hints from the last response (0 = not sent)
+  uint32_t maxAge = 0;     // Cache-Control max-age, seconds
+  uint32_t retryAfter = 0; // Retry-After, seconds
+  uint32_t nextWake = 0;   // X-Next-Wake, epoch (or seconds if < 1e9)
+};
+
+// Builds the X-Inky-Caps request header value (see board_traits.h); a
+// negative battery percentage is left out
+String DeviceCaps(int rotation, int batteryPercent = -1);
+
+// Fetches a JPEG image from the renderer into memory. Network only (no
+// display access), so it can run on a network worker task.
+esp_err_t FetchImage(int rotation, const char *api,
+                     const AppConfig::Renderer &imageConfig,
+                     const char *endpoint, FetchedImage &image,
+                     int batteryPercent = -1);
+
+// Decodes a fetched image and draws it (plus header messages) to the Inkplate
+esp_err_t RenderImage(Inkplate &display, int rotation, FetchedImage &image);
 
 // Fetches a JPEG image from a URL and renders it to the Inkplate
 esp_err_t DisplayImage(Inkplate &display, int rotation, const char *api,
-                       const JsonVariant &imageConfig,
+                       const AppConfig::Renderer &imageConfig,
                        const char *renderEndpoint);
 
-// Reads data from a WiFi stream into a byte vector (PSRAM friendly)
+// Reads data from a WiFi stream into a byte vector (PSRAM friendly). When an
+// inflater is given, the body is decompressed as it arrives. 'wireBytes'
+// receives the number of body bytes read off the socket.
 PsramVector readStream(WiFiClient &stream, unsigned long timeoutMillis,
-                                bool isChunked, size_t contentLength);
+                       bool isChunked, size_t contentLength,
+                       size_t readSize = READSTREAM_READ_SIZE,
+                       Inflater *inflater = nullptr,
+                       size_t *wireBytes = nullptr);
+
+// Same as above, but waits on the TLS client's underlying socket
+PsramVector readStream(WiFiClientSecure &stream, unsigned long timeoutMillis,
+                       bool isChunked, size_t contentLength,
+                       size_t readSize = READSTREAM_READ_SIZE,
+                       Inflater *inflater = nullptr,
+                       size_t *wireBytes = nullptr);
 
 // Starts the OTA web server and blocks execution until timeout or reboot
 void StartOTAServer(Inkplate &display, int rotation);
@@ -0,0 +1,51 @@
+#ifndef POWER_PROFILE_H
+#define POWER_PROFILE_H
+
+#include <Arduino.h>
+
+// Set to 0 to run at the board_build.f_cpu clock throughout
+#ifndef POWER_PROFILE_ENABLED
+#define POWER_PROFILE_ENABLED 1
+#endif
+
+// CPU clock for CPU bound work (MHz)
+#ifndef POWER_HIGH_MHZ
+#define POWER_HIGH_MHZ 240
+#endif
+
+// CPU clock while waiting on I/O (MHz); 80 is the lowest WiFi runs at
+#ifndef POWER_LOW_MHZ
+#define POWER_LOW_MHZ 80
+#endif
+
+// Keep the high clock for panel refreshes. The Inkplate clocks each
+// waveform phase out to the panel from the CPU, so a slower clock stretches
+// the refresh (and its panel current) rather than saving anything.
+#ifndef POWER_REFRESH_BOOST
+#define POWER_REFRESH_BOOST 1
+#endif
+
+// Per-phase CPU clock. The wake runs at POWER_LOW_MHZ (association,
+// waiting on the server, the deep sleep shutdown), and CPU bound phases
+// (TLS handshakes, JPEG conversion, decode and dithering) hold a Boost for
+// POWER_HIGH_MHZ. Boosts are counted, so phases on the network workers and
+// the main task overlap safely; the clock drops once the last one ends.
+namespace PowerProfile {
+// Drop to the low clock (call once, early in setup)
+void begin();
+
+// Holds the high clock from construction to destruction
+class Boost {
+public:
+  explicit Boost(bool enable = true);
+  ~Boost();
+
+  Boost(const Boost &) = delete;
+  Boost &operator=(const Boost &) = delete;
+
+private:
+  bool _held;
+};
+} // namespace PowerProfile
+
+#endif
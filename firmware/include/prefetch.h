@@ -0,0 +1,36 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <Arduino.h>
+
+#include "networking.h"
+
+#ifndef PREFETCH_IMAGE_PATH
+#define PREFETCH_IMAGE_PATH "/prefetch.jpg"
+#endif
+
+#ifndef PREFETCH_META_PATH
+#define PREFETCH_META_PATH "/prefetch.json"
+#endif
+
+// Free space to leave on LittleFS after storing a prefetched image
+#ifndef PREFETCH_FS_RESERVE
+#define PREFETCH_FS_RESERVE (16 * 1024)
+#endif
+
+// Keeps the image for the next scheduled wake on LittleFS, so that wake can
+// draw it before the radio is even up. The JPEG is stored as received
+// (already compressed), with the endpoint and render hints alongside.
+namespace Prefetch {
+// Load the stored image if it was fetched for 'endpoint' no more than
+// 'maxAgeSeconds' ago. The stored copy is consumed either way.
+bool load(const char *endpoint, uint32_t maxAgeSeconds, FetchedImage &image);
+
+// Store an image for 'endpoint'; false if it doesn't fit or the write fails
+bool store(const char *endpoint, const FetchedImage &image);
+
+// Remove any stored image
+void clear();
+} // namespace Prefetch
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 #include <memory>
+#include <new>
+#include <utility>
 #include <vector>
 
 // Custom allocator to force std::vector to use PSRAM (External SPI RAM).
@@ -50,6 +52,17 @@ template <class T> struct PsramAllocator {
 
   // Deallocate
   void deallocate(T *p, std::size_t) noexcept { free(p); }
+
+  // Default-initialize on resize() so growing a byte vector before reading
+  // into it doesn't zero memory that is about to be overwritten
+  template <class U> void construct(U *p) noexcept {
+    ::new (static_cast<void *>(p)) U;
+  }
+
+  // Forward everything else to the regular constructor
+  template <class U, class... Args> void construct(U *p, Args &&...args) {
+    ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+  }
 };
 
 // Boilerplate equality operators
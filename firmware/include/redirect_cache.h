@@ -0,0 +1,34 @@
+#ifndef REDIRECT_CACHE_H
+#define REDIRECT_CACHE_H
+
+#include <Arduino.h>
+
+#include "simplehttp.h"
+
+// Longest API base that can be remembered
+#ifndef REDIRECT_CACHE_URL_LEN
+#define REDIRECT_CACHE_URL_LEN 96
+#endif
+
+// How long a permanent redirect is trusted, in seconds (1 day)
+#ifndef REDIRECT_CACHE_TTL
+#define REDIRECT_CACHE_TTL 86400
+#endif
+
+// Remembers, in RTC memory, where a permanent redirect (301/308) moved the
+// API base, so later wakes request the final location directly instead of
+// paying for an extra connect and TLS handshake every time.
+namespace RedirectCache {
+// The base URL to use for 'api': the cached target if there is a live entry
+// for it, otherwise 'api' itself
+const char *apply(const char *api);
+
+// Inspect a finished request made against 'base' (the value apply()
+// returned). Learns the new base if 'url' was permanently redirected to a
+// location that keeps the path below the base, and drops the cached target
+// if it stopped working.
+void observe(const char *base, const String &url, SimpleHTTP &http,
+             int code);
+} // namespace RedirectCache
+
+#endif
@@ -6,12 +6,42 @@
 #include <base64.h>
 #include <map>
 
+#include "inflater.h"
+
 // Default settings
 #define SIMPLEHTTP_MAX_REDIRECTS 5
 #define SIMPLEHTTP_DEFAULT_TIMEOUT 5000
 
+// Largest body getString() reads (decompressed); it lives in internal heap
+#ifndef SIMPLEHTTP_MAX_STRING
+#define SIMPLEHTTP_MAX_STRING 16384
+#endif
+
 class SimpleHTTP {
 public:
+  // Opens the connection for a request (e.g. to use cached DNS results);
+  // returns false on failure
+  // 'resolvedAt' is set to millis() once the host has been resolved.
+  typedef bool (*Connector)(Client &client, const char *host, uint16_t port,
+                            unsigned long &resolvedAt);
+
+  // Milliseconds from the start of GET() to the end of each phase of the
+  // last request (0 if not reached), plus bytes moved. For TLS clients
+  // 'connected' includes the handshake. Phases before 'hopStart' belong to
+  // earlier redirect hops.
+  struct Timing {
+    uint32_t hopStart;  // Final (non-redirect) request started
+    uint32_t resolved;  // DNS done (== hopStart without a connector)
+    uint32_t connected; // TCP (+ TLS) connected
+    uint32_t sent;      // Request written
+    uint32_t firstByte; // First response byte available
+    uint32_t headers;   // Status line + headers parsed
+    uint32_t body;      // Body read (getString() or markBodyComplete())
+    uint32_t bytesSent;
+    uint32_t bytesReceived; // Headers + body as received (before inflating)
+    uint8_t redirects;
+  };
+
   inline SimpleHTTP();
   inline ~SimpleHTTP();
 
@@ -22,7 +52,7 @@ public:
   // Close the connection
   inline void end();
 
-  // Add a custom header to the request
+  // Add a custom header to the request (begin() clears them)
   inline void addHeader(const String &name, const String &value);
 
   // Set the User-Agent header
@@ -31,17 +61,46 @@ public:
   // Set the read timeout (milliseconds)
   inline void setTimeout(unsigned long timeout);
 
+  // Advertise gzip/deflate support (Accept-Encoding) on the next request
+  inline void setAcceptEncoding(bool enable);
+
+  // Use a custom connector instead of Client::connect(host, port)
+  inline void setConnector(Connector connector);
+
   // Define which response headers to collect
   inline void collectHeaders(const char *headerKeys[],
                              const size_t headerCount);
 
   // Execute the HTTP GET request
-  // Returns status code (e.g. 200) or negative error (-1: Connect, -2: Timeout)
+  // Returns status code (e.g. 200) or negative error (-1: Connect/Write,
+  // -2: Timeout, -3: Too many redirects)
   inline int GET();
 
-  // Read response body into a String (handles chunked encoding)
+  // Read response body into a String (handles chunked and compressed bodies)
+  // Empty if the body is larger than SIMPLEHTTP_MAX_STRING
   inline String getString();
 
+  // True if the response body has a Content-Encoding other than identity
+  inline bool isEncoded();
+
+  // Inflater for the response body, or nullptr if the body isn't encoded
+  // (or uses an unsupported encoding / the window couldn't be allocated)
+  inline Inflater *getInflater();
+
+  // True if the response uses chunked transfer encoding
+  inline bool isChunked();
+
+  // Phase timestamps and byte counts of the last request
+  inline const Timing &getTiming();
+
+  // Where the last request ended up if every redirect it followed was
+  // permanent (301/308); empty otherwise
+  inline const String &getPermanentURL();
+
+  // For external stream readers: record the end of the body and how many
+  // body bytes came off the wire
+  inline void markBodyComplete(size_t wireBytes);
+
   // Get raw WiFiClient pointer (for external stream readers)
   inline WiFiClient *getStreamPtr();
 
@@ -63,6 +122,8 @@ private:
   String _userAgent;
   String _customHeaders;
   unsigned long _timeout;
+  bool _acceptEncoding;
+  Connector _connector;
 
   // Header collection
   const char **_headerKeys;
@@ -73,6 +134,13 @@ private:
   int _httpCode;
   int _contentLength;
   bool _isChunked;
+  String _contentEncoding;
+  Inflater _inflater;
+
+  // Instrumentation
+  unsigned long _start;
+  Timing _timing;
+  String _permanentUrl;
 
   // Helpers
   inline int parseResponse();
@@ -81,8 +149,9 @@ private:
 
 inline SimpleHTTP::SimpleHTTP()
     : _client(nullptr), _timeout(SIMPLEHTTP_DEFAULT_TIMEOUT),
-      _headerKeys(nullptr), _headerCount(0), _httpCode(0), _contentLength(-1),
-      _isChunked(false) {
+      _acceptEncoding(false), _connector(nullptr), _headerKeys(nullptr),
+      _headerCount(0), _httpCode(0), _contentLength(-1), _isChunked(false),
+      _start(0), _timing() {
   _userAgent = "ESP32-SimpleHTTP/1.0";
 }
 
@@ -91,6 +160,7 @@ inline SimpleHTTP::~SimpleHTTP() { end(); }
 inline bool SimpleHTTP::begin(Client &client, const String &url) {
   _client = &client;
   _url = url;
+  _customHeaders = "";
   cleanState();
   return true;
 }
@@ -113,6 +183,14 @@ inline void SimpleHTTP::setTimeout(unsigned long timeout) {
   _timeout = timeout;
 }
 
+inline void SimpleHTTP::setAcceptEncoding(bool enable) {
+  _acceptEncoding = enable;
+}
+
+inline void SimpleHTTP::setConnector(Connector connector) {
+  _connector = connector;
+}
+
 inline void SimpleHTTP::collectHeaders(const char *headerKeys[],
                                        const size_t headerCount) {
   _headerKeys = headerKeys;
@@ -123,6 +201,8 @@ inline void SimpleHTTP::cleanState() {
   _httpCode = 0;
   _contentLength = -1;
   _isChunked = false;
+  _contentEncoding = "";
+  _inflater.end();
   _collectedHeaders.clear();
 }
 
@@ -131,10 +211,19 @@ inline int SimpleHTTP::GET() {
     return -1;
 
   int redirects = 0;
+  bool permanent = true;
   String currentUrl = _url;
+  _start = millis();
+  _timing = Timing();
+  _permanentUrl = "";
+
+  // Milliseconds since GET() started
+  auto since = [this](unsigned long t) { return (uint32_t)(t - _start); };
 
   while (redirects <= SIMPLEHTTP_MAX_REDIRECTS) {
     cleanState();
+    _timing.hopStart = since(millis());
+    _timing.redirects = redirects;
 
     // Manual URL Parsing
     String protocol = "http";
@@ -189,33 +278,58 @@ inline int SimpleHTTP::GET() {
     }
 
     // Connect
-    if (!_client->connected())
-      if (!_client->connect(host.c_str(), port))
+    if (!_client->connected()) {
+      unsigned long resolvedAt = millis();
+      bool connected =
+          _connector ? _connector(*_client, host.c_str(), port, resolvedAt)
+                     : _client->connect(host.c_str(), port);
+      _timing.resolved = since(resolvedAt);
+      if (!connected)
         return -1; // Connection failed
-
-    // Send Request
-    _client->print("GET ");
-    _client->print(path);
-    _client->print(" HTTP/1.1\r\n");
-    _client->print("Host: ");
-    _client->print(host);
-    _client->print("\r\n");
-    _client->print("User-Agent: ");
-    _client->print(_userAgent);
-    _client->print("\r\n");
-    _client->print("Connection: close\r\n");
+    } else {
+      _timing.resolved = _timing.hopStart;
+    }
+    _timing.connected = since(millis());
+
+    // Build the whole request in one buffer so it goes out as a single
+    // write (one TLS record / TCP segment instead of one per header)
+    String auth;
+    if (authUser.length() > 0)
+      auth = base64::encode(authUser + ":" + authPass);
+
+    String request;
+    request.reserve(64 + path.length() + host.length() + _userAgent.length() +
+                    auth.length() + _customHeaders.length());
+    request += "GET ";
+    request += path;
+    request += " HTTP/1.1\r\nHost: ";
+    request += host;
+    request += "\r\nUser-Agent: ";
+    request += _userAgent;
+    request += "\r\nConnection: close\r\n";
+
+    // Let the server compress the body; it's inflated as it's read
+    if (_acceptEncoding)
+      request += "Accept-Encoding: gzip, deflate\r\n";
 
     // Handle Basic Auth (from URL or manually added)
-    if (authUser.length() > 0) {
-      String auth = authUser + ":" + authPass;
-      _client->print("Authorization: Basic ");
-      _client->print(base64::encode(auth));
-      _client->print("\r\n");
+    if (auth.length() > 0) {
+      request += "Authorization: Basic ";
+      request += auth;
+      request += "\r\n";
     }
 
-    if (_customHeaders.length() > 0)
-      _client->print(_customHeaders);
-    _client->print("\r\n");
+    request += _customHeaders;
+    request += "\r\n";
+
+    // Send Request
+    if (_client->write((const uint8_t *)request.c_str(), request.length()) !=
+        request.length()) {
+      end();
+      return -1; // Write failed
+    }
+    _timing.sent = since(millis());
+    _timing.bytesSent += request.length();
 
     // Wait for Response
     unsigned long start = millis();
@@ -226,12 +340,14 @@ inline int SimpleHTTP::GET() {
       }
       delay(10);
     }
+    _timing.firstByte = since(millis());
 
     // Parse Headers
     int code = parseResponse();
+    _timing.headers = since(millis());
 
     // Handle Redirects
-    if (code == 301 || code == 302 || code == 307) {
+    if (code == 301 || code == 302 || code == 307 || code == 308) {
       if (_collectedHeaders.count("Location")) {
         String newLoc = _collectedHeaders["Location"];
 
@@ -243,6 +359,10 @@ inline int SimpleHTTP::GET() {
           currentUrl = newLoc;
         }
 
+        // Remember the target while the whole chain is permanent
+        permanent = permanent && (code == 301 || code == 308);
+        _permanentUrl = permanent ? currentUrl : "";
+
         end(); // Close before redirecting
         redirects++;
         continue;
@@ -259,6 +379,7 @@ inline int SimpleHTTP::GET() {
 inline int SimpleHTTP::parseResponse() {
   // Read status line
   String statusLine = _client->readStringUntil('\n');
+  _timing.bytesReceived += statusLine.length() + 1;
   statusLine.trim();
 
   int firstSpace = statusLine.indexOf(' ');
@@ -271,6 +392,7 @@ inline int SimpleHTTP::parseResponse() {
   // Read headers
   while (true) {
     String line = _client->readStringUntil('\n');
+    _timing.bytesReceived += line.length() + 1;
     line.trim();
     if (line.length() == 0)
       break; // End of headers
@@ -287,6 +409,8 @@ inline int SimpleHTTP::parseResponse() {
       } else if (key.equalsIgnoreCase("Transfer-Encoding")) {
         if (val.equalsIgnoreCase("chunked"))
           _isChunked = true;
+      } else if (key.equalsIgnoreCase("Content-Encoding")) {
+        _contentEncoding = val;
       } else if (key.equalsIgnoreCase("Location")) {
         _collectedHeaders["Location"] = val;
       }
@@ -309,9 +433,50 @@ inline String SimpleHTTP::getString() {
   if (!_client)
     return "";
 
+  // Encoded bodies we can't inflate would only yield garbage
+  Inflater *inflater = getInflater();
+  if (isEncoded() && !inflater)
+    return "";
+
+  if (_contentLength > SIMPLEHTTP_MAX_STRING)
+    return "";
+
+  // Result so far; 'overflow' once it would pass SIMPLEHTTP_MAX_STRING
+  struct Body {
+    String text;
+    bool overflow = false;
+  } body;
+  if (!inflater && _contentLength > 0)
+    body.text.reserve(_contentLength);
+
+  // Appends (decompressed) body data to the result
+  Inflater::Sink append = [](void *ctx, const uint8_t *data, size_t len) {
+    Body *body = static_cast<Body *>(ctx);
+    if (body->overflow ||
+        body->text.length() + len > SIMPLEHTTP_MAX_STRING) {
+      body->overflow = true;
+      return;
+    }
+    body->text.concat((const char *)data, len);
+  };
+  auto consume = [&](const uint8_t *data, size_t len) -> bool {
+    if (inflater && !inflater->write(data, len, append, &body))
+      return false;
+    if (!inflater)
+      append(&body, data, len);
+    return !body.overflow;
+  };
+
+  // Counts body bytes as they come off the wire
+  size_t wireBytes = 0;
+  auto finish = [&]() -> String {
+    markBodyComplete(wireBytes);
+    return body.overflow ? String() : std::move(body.text);
+  };
+
+  uint8_t buf[512];
   if (_isChunked) {
-    String result = "";
-    while (_client->connected()) {
+    while (_client->connected() || _client->available() > 0) {
       String line = _client->readStringUntil('\n'); // Chunk size
       line.trim();
       long chunkSize = strtol(line.c_str(), NULL, 16);
@@ -320,19 +485,73 @@ inline String SimpleHTTP::getString() {
 
       // Read chunk data
       long remaining = chunkSize;
-      while (remaining > 0 && _client->connected()) {
-        if (_client->available()) {
-          char c = _client->read();
-          result += c;
-          remaining--;
-        }
+      while (remaining > 0) {
+        int n = _client->readBytes(buf, min<long>(remaining, sizeof(buf)));
+        if (n > 0)
+          wireBytes += n;
+        if (n <= 0 || !consume(buf, n))
+          return finish();
+        remaining -= n;
       }
       _client->readStringUntil('\n'); // Skip chunk CRLF
     }
-    return result;
   } else {
-    return _client->readString();
+    // Read until Content-Length is satisfied or the server closes
+    long remaining = _contentLength;
+    unsigned long lastData = millis();
+    while (remaining != 0 && millis() - lastData < _timeout) {
+      int avail = _client->available();
+      if (avail <= 0) {
+        if (!_client->connected())
+          break;
+        delay(1);
+        continue;
+      }
+
+      size_t want = min<size_t>(avail, sizeof(buf));
+      if (remaining > 0)
+        want = min<size_t>(want, remaining);
+
+      int n = _client->read(buf, want);
+      if (n > 0)
+        wireBytes += n;
+      if (n <= 0 || !consume(buf, n))
+        break;
+      if (remaining > 0)
+        remaining -= n;
+      lastData = millis();
+    }
   }
+  return finish();
+}
+
+inline bool SimpleHTTP::isEncoded() {
+  return _contentEncoding.length() > 0 &&
+         !_contentEncoding.equalsIgnoreCase("identity");
+}
+
+inline Inflater *SimpleHTTP::getInflater() {
+  if (!isEncoded())
+    return nullptr;
+
+  if (!_inflater.active()) {
+    Inflater::Format format;
+    if (!Inflater::formatFor(_contentEncoding, format) ||
+        !_inflater.begin(format))
+      return nullptr;
+  }
+  return &_inflater;
+}
+
+inline bool SimpleHTTP::isChunked() { return _isChunked; }
+
+inline const SimpleHTTP::Timing &SimpleHTTP::getTiming() { return _timing; }
+
+inline const String &SimpleHTTP::getPermanentURL() { return _permanentUrl; }
+
+inline void SimpleHTTP::markBodyComplete(size_t wireBytes) {
+  _timing.body = (uint32_t)(millis() - _start);
+  _timing.bytesReceived += wireBytes;
 }
 
 inline WiFiClient *SimpleHTTP::getStreamPtr() { return (WiFiClient *)_client; }
@@ -2,9 +2,11 @@
 #define TIME_UTILS_H
 
 #include "time.h"
-#include <ArduinoJson.h>
+#include <Arduino.h>
 #include <map>
 
+#include "config_snapshot.h"
+
 // Define a structure to hold parsed time values
 struct ParsedTime {
   int hour;
@@ -19,6 +21,33 @@ struct WakeEntry {
   String time;
 };
 
+// Scheduling hints from the server's last response and the battery budget
+// (0 = not given)
+struct WakeHints {
+  time_t notBefore;     // Don't wake before this (Retry-After)
+  time_t freshUntil;    // 'endpoint' won't change before this (max-age)
+  time_t wakeBy;        // Wake no later than this (X-Next-Wake)
+  uint32_t minInterval; // Space interval wakes at least this far apart
+  String endpoint;      // Endpoint the hints came from
+  String time;          // Its wake key ("" for the default endpoint)
+};
+
+// Wakes the compiled schedule in RTC memory holds (4 bytes each); bigger
+// schedules are scanned from the config on every wake instead
+#ifndef WAKE_TABLE_MAX
+#define WAKE_TABLE_MAX 256
+#endif
+
+// Most wakes calculateNextWake() will skip while honoring 'freshUntil'
+#ifndef WAKE_HINT_MAX_SKIPS
+#define WAKE_HINT_MAX_SKIPS 96
+#endif
+
+// Soonest (seconds from now) a server's 'wakeBy' can bring the next wake
+#ifndef WAKE_HINT_MIN_SECONDS
+#define WAKE_HINT_MIN_SECONDS 300
+#endif
+
 // Get the current local time as a string (e.g. "2025-01-01 12:00:00 AM")
 String getLocalTimestamp(time_t epochFallback = 0);
 
@@ -39,16 +68,36 @@ int parseDuration(const String &durationStr);
 time_t getNextIntervalTime(time_t now, const String &intervalStr = "");
 
 // Find the earliest scheduled wake time that is strictly after the given time
-WakeEntry getNextScheduledWake(time_t now, const JsonObject &wakes);
+WakeEntry getNextScheduledWake(time_t now, const WakeSlot *wakes,
+                               size_t wakeCount);
 
-// Calculates the next wake time based on the sleep window and wake schedule
+// Calculates the next wake time based on the sleep window and wake schedule.
+// The schedule is compiled into RTC memory the first time it is seen (and
+// again whenever it changes), so later wakes only do a binary search.
+// With 'hints', wakes before Retry-After and wakes that would refetch content
+// that is still fresh are skipped, and X-Next-Wake can bring the wake
+// forward (never into the sleep window). 'minInterval' stretches interval
+// wakes only; scheduled wakes keep their times.
 WakeEntry calculateNextWake(time_t currentEpoch, const String &sleepStartStr,
-                            const String &sleepStopStr, const JsonObject &wakes,
-                            const String &defaultEndpoint,
-                            const String &intervalStr = "");
+                            const String &sleepStopStr, const WakeSlot *wakes,
+                            size_t wakeCount, const String &defaultEndpoint,
+                            const String &intervalStr = "",
+                            const WakeHints *hints = nullptr);
+
+// Resolves the timezone's POSIX TZ rule (configured, remembered from an
+// earlier lookup, or from the timezone API) and waits for SNTP to set the
+// system clock. Doesn't touch the RTC, so it can run on a network worker
+// task.
+esp_err_t NTPFetch(const char *api, const AppConfig::Ntp &ntpConfig);
+
+// Writes the synchronized system time to the RTC. 'fetchResult' is the
+// return value of NTPFetch; on failure the RTC keeps its time (an RTC that
+// was never set is reset). The RTC's error before the write is recorded for
+// ClockDrift.
+esp_err_t NTPCommit(Inkplate &display, esp_err_t fetchResult);
 
-// Synchronizes the system time using NTP
+// Synchronizes the system time using NTP (NTPFetch + NTPCommit)
 esp_err_t NTPSync(Inkplate &display, const char *api,
-                  const JsonVariant &ntpConfig);
+                  const AppConfig::Ntp &ntpConfig);
 
 #endif
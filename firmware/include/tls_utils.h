@@ -1,18 +1,24 @@
 #ifndef TLS_UTILS_H
 #define TLS_UTILS_H
 
-#include <ArduinoJson.h>
 #include <WiFiClientSecure.h>
 
-// Holding the CA bundle (which can be 200KB+) in a global variable permanently
-// reduces the heap available for image processing
-// Instead, we store the *path* and load it temporarily only when needed
-bool TLSLoadCACert(const JsonVariant &config);
+#include "config_snapshot.h"
+
+// Loads the CA bundle (up to 50KB) into PSRAM, so it doesn't take heap away
+// from image processing. It stays loaded for the rest of the wake, since
+// clients only keep a pointer to it.
+bool TLSLoadCACert(const AppConfig::Security &security);
 
 // Applies the loaded CA bundle to a WiFiClientSecure instance.
 // Returns false if no CA cert has been loaded yet.
 bool TLSConfigureClient(WiFiClientSecure &client);
 
+// Connects a configured client to an already resolved address, still using
+// 'host' for SNI and certificate verification
+bool TLSConnect(WiFiClientSecure &client, const IPAddress &ip, uint16_t port,
+                const char *host);
+
 // Returns the currently configured CA certificate file path.
 const char *TLSGetCACertPath();
 
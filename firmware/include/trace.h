@@ -0,0 +1,94 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Print.h>
+#else
+#include <stdio.h>
+#endif
+
+// Set to 0 to compile every TRACE_* macro away
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+// Zones remembered across deep sleep (oldest are overwritten)
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 32
+#endif
+
+// Zone names are truncated to this (including the terminator)
+#ifndef TRACE_NAME_LEN
+#define TRACE_NAME_LEN 12
+#endif
+
+// Distinct tasks that can show up in a trace
+#ifndef TRACE_MAX_THREADS
+#define TRACE_MAX_THREADS 6
+#endif
+
+// Wake timeline profiler. A zone records its start and duration
+// (esp_timer, microseconds since boot) and the free internal heap and PSRAM
+// at entry and exit, plus the low-water marks at exit. Finished zones go
+// into an RTC ring, so a trace can cover several wakes, and are exported as
+// Chrome trace-event JSON (chrome://tracing, Perfetto) with one process per
+// wake and one thread per task.
+//
+// Off the device (no ARDUINO) the same macros build against std::chrono,
+// with the memory columns reading 0, so host benchmarks give comparable
+// traces.
+namespace Trace {
+// Times a zone from construction until end() or destruction
+class Zone {
+public:
+  explicit Zone(const char *name);
+  ~Zone() { end(); }
+
+  // Close the zone early (later calls do nothing)
+  void end();
+
+  Zone(const Zone &) = delete;
+  Zone &operator=(const Zone &) = delete;
+
+private:
+  const char *_name;
+  uint32_t _start;
+  uint32_t _heap;
+  uint32_t _psram;
+};
+
+// Start a new wake (call once, early in setup)
+void begin();
+
+#ifdef ARDUINO
+// Write every zone in the ring as Chrome trace JSON; returns bytes written
+size_t writeJson(Print &out);
+
+// Publish the zones not exported yet (the end of the last wake and this
+// one so far) to the MQTT log topic + "/trace"
+bool publish();
+#else
+size_t writeJson(FILE *out);
+#endif
+} // namespace Trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#if TRACE_ENABLED
+// Time the rest of the enclosing scope
+#define TRACE_ZONE(name) Trace::Zone TRACE_CONCAT(_traceZone, __LINE__)(name)
+
+// Time a zone that doesn't follow a scope; 'id' names the local variable
+#define TRACE_BEGIN(id, name) Trace::Zone _traceZone_##id(name)
+#define TRACE_END(id) _traceZone_##id.end()
+#else
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_BEGIN(id, name) ((void)0)
+#define TRACE_END(id) ((void)0)
+#endif
+
+#endif
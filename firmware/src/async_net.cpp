@@ -0,0 +1,173 @@
+#include "async_net.h"
+#include "logger.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+namespace AsyncNet {
+// Submitted job plus its completion state
+struct Request {
+  const char *name;
+  Job job;
+  esp_err_t result;
+  bool done;
+  int refs; // Owner + worker; whoever drops the last one frees it
+  unsigned long started;
+  unsigned long finished;
+  SemaphoreHandle_t doneSem;
+};
+
+namespace {
+QueueHandle_t jobQueue = nullptr;
+portMUX_TYPE stateMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Free a request and its semaphore
+void destroy(Request *req) {
+  if (req->doneSem)
+    vSemaphoreDelete(req->doneSem);
+  delete req;
+}
+
+// Drop a reference, freeing the request when it was the last one
+void unref(Request *req) {
+  portENTER_CRITICAL(&stateMux);
+  bool last = --req->refs == 0;
+  portEXIT_CRITICAL(&stateMux);
+
+  if (last)
+    destroy(req);
+}
+
+// Run a job, publish its result and drop the worker's reference
+void execute(Request *req) {
+  req->started = millis();
+  esp_err_t result = req->job();
+
+  portENTER_CRITICAL(&stateMux);
+  req->result = result;
+  req->finished = millis();
+  req->done = true;
+  portEXIT_CRITICAL(&stateMux);
+
+  if (req->doneSem)
+    xSemaphoreGive(req->doneSem);
+  unref(req);
+}
+
+// Worker loop: run jobs as they arrive
+void workerTask(void *) {
+  Request *req = nullptr;
+  while (true) {
+    if (xQueueReceive(jobQueue, &req, portMAX_DELAY) != pdTRUE)
+      continue;
+
+    execute(req);
+  }
+}
+} // namespace
+
+// Start the worker tasks
+bool begin() {
+  if (jobQueue)
+    return true;
+
+  jobQueue = xQueueCreate(ASYNC_NET_QUEUE_DEPTH, sizeof(Request *));
+  if (!jobQueue) {
+    Logger::log(Logger::LOG_ERROR, "AsyncNet: failed to create job queue");
+    return false;
+  }
+
+  for (int i = 0; i < ASYNC_NET_WORKERS; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "net-%d", i);
+    if (xTaskCreate(workerTask, name, ASYNC_NET_STACK_SIZE, nullptr, 1,
+                    nullptr) != pdPASS) {
+      Logger::logf(Logger::LOG_ERROR, "AsyncNet: failed to start worker %d",
+                   i);
+      return i > 0; // Fewer workers still work, just with less overlap
+    }
+  }
+  return true;
+}
+
+// Queue a job
+Handle submit(const char *name, Job job) {
+  Request *req = new Request();
+  req->name = name;
+  req->job = std::move(job);
+  req->result = ESP_FAIL;
+  req->done = false;
+  req->refs = 2;
+  req->started = 0;
+  req->finished = 0;
+  req->doneSem = xSemaphoreCreateBinary();
+
+  // Without a worker, run the job right here so callers don't need a
+  // separate synchronous path
+  if (!req->doneSem || (!jobQueue && !begin()) ||
+      xQueueSend(jobQueue, &req, 0) != pdTRUE) {
+    Logger::logf(Logger::LOG_WARNING, "AsyncNet: running '%s' inline", name);
+    execute(req);
+    return req;
+  }
+
+  Logger::logf(Logger::LOG_DEBUG, "AsyncNet: queued '%s'", name);
+  return req;
+}
+
+// True once the job has finished
+bool poll(Handle handle) {
+  if (!handle)
+    return true;
+
+  portENTER_CRITICAL(&stateMux);
+  bool done = handle->done;
+  portEXIT_CRITICAL(&stateMux);
+  return done;
+}
+
+// Wait for the job to finish
+esp_err_t await(Handle handle, unsigned long timeoutMs) {
+  if (!handle)
+    return ESP_ERR_INVALID_ARG;
+
+  if (!poll(handle)) {
+    if (xSemaphoreTake(handle->doneSem, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) {
+      Logger::logf(Logger::LOG_WARNING,
+                   "AsyncNet: '%s' still running after %lu ms", handle->name,
+                   timeoutMs);
+      return ESP_ERR_TIMEOUT;
+    }
+    // Leave the semaphore signalled for any later await()
+    xSemaphoreGive(handle->doneSem);
+  }
+  return handle->result;
+}
+
+// Release the handle; a running job frees itself when it finishes
+void release(Handle handle) {
+  if (handle)
+    unref(handle);
+}
+
+// await() + release()
+esp_err_t finish(Handle handle, unsigned long timeoutMs) {
+  esp_err_t result = await(handle, timeoutMs);
+  if (handle) {
+    if (poll(handle))
+      Logger::logf(Logger::LOG_DEBUG, "AsyncNet: '%s' finished in %lu ms (%s)",
+                   handle->name, elapsed(handle), esp_err_to_name(result));
+    release(handle);
+  }
+  return result;
+}
+
+// Wall time the job spent running
+unsigned long elapsed(Handle handle) {
+  if (!handle || !poll(handle))
+    return 0;
+  return handle->finished - handle->started;
+}
+} // namespace AsyncNet
@@ -42,3 +42,19 @@ int getBatteryPercentage(float voltage) {
 
   return 0; // Default to 0% if voltage is below the lowest threshold
 }
+
+// Linear interpolation between the table's entries, as a fraction
+float getBatteryCharge(float voltage) {
+  if (voltage >= voltageTable[0][0])
+    return 1.0f;
+
+  for (int i = 1; i < numVoltagePoints; i++) {
+    if (voltage >= voltageTable[i][0]) {
+      float v0 = voltageTable[i][0], v1 = voltageTable[i - 1][0];
+      float p0 = voltageTable[i][1], p1 = voltageTable[i - 1][1];
+      return (p0 + (voltage - v0) / (v1 - v0) * (p1 - p0)) / 100.0f;
+    }
+  }
+
+  return 0.0f;
+}
@@ -0,0 +1,108 @@
+#include "battery_history.h"
+#include "battery.h"
+#include "logger.h"
+
+#include <esp_attr.h>
+
+#define BATTERY_HISTORY_MAGIC 0x42415454 // "BATT"
+
+namespace BatteryHistory {
+// One wake
+struct Sample {
+  uint32_t epoch;
+  uint16_t millivolts;
+};
+
+// The wakes since the last charge, kept across deep sleep
+struct State {
+  uint32_t magic;
+  uint32_t chargedAt; // Epoch of the first wake after the charge
+  uint16_t lowest;    // Lowest reading since the charge (mV)
+  uint8_t head;       // Next slot to write
+  uint8_t count;      // Samples in the ring
+  Sample ring[BATTERY_HISTORY_SIZE];
+};
+
+RTC_DATA_ATTR static State state;
+
+// Start a new history
+static void reset() {
+  state = {};
+  state.magic = BATTERY_HISTORY_MAGIC;
+}
+
+// Record this wake's battery voltage
+void record(time_t now, float voltage) {
+  uint16_t millivolts = (uint16_t)(voltage * 1000.0f + 0.5f);
+  if (state.magic != BATTERY_HISTORY_MAGIC)
+    reset();
+
+  if (state.count) {
+    // Charging shows up as a rise over the lowest reading (a slow charge
+    // never jumps from one wake to the next); a clock that went back
+    // makes the history useless
+    const Sample &last =
+        state.ring[(state.head + BATTERY_HISTORY_SIZE - 1) %
+                   BATTERY_HISTORY_SIZE];
+    if (millivolts >= state.lowest + BATTERY_CHARGE_JUMP * 1000.0f ||
+        (uint32_t)now < last.epoch) {
+      Logger::log(Logger::LOG_DEBUG, "Battery: charged, history restarted.");
+      reset();
+    }
+  }
+
+  if (!state.count) {
+    state.chargedAt = now;
+    state.lowest = millivolts;
+  }
+  state.lowest = min(state.lowest, millivolts);
+  state.ring[state.head] = {(uint32_t)now, millivolts};
+  state.head = (state.head + 1) % BATTERY_HISTORY_SIZE;
+  if (state.count < BATTERY_HISTORY_SIZE)
+    state.count++;
+}
+
+// Interval wakes needed to last until chargedAt + runtime
+uint32_t intervalFloor(time_t now, uint32_t runtime, size_t scheduledPerDay) {
+  if (!runtime || state.magic != BATTERY_HISTORY_MAGIC ||
+      state.count < BATTERY_HISTORY_MIN)
+    return 0;
+
+  time_t deadline = (time_t)state.chargedAt + runtime;
+  if (now >= deadline)
+    return 0;
+
+  // Least-squares line through the charge over the wakes, oldest first: the
+  // slope is the cost of a wake, the end of the line the charge left (less
+  // noisy than the last reading)
+  float n = state.count, sx = 0, sy = 0, sxy = 0, sxx = 0;
+  size_t oldest = (state.head + BATTERY_HISTORY_SIZE - state.count) %
+                  BATTERY_HISTORY_SIZE;
+  for (size_t i = 0; i < state.count; i++) {
+    const Sample &s = state.ring[(oldest + i) % BATTERY_HISTORY_SIZE];
+    float y = getBatteryCharge(s.millivolts / 1000.0f);
+    sx += i;
+    sy += y;
+    sxy += i * y;
+    sxx += (float)i * i;
+  }
+  float slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+  float perWake = -slope;
+  if (perWake <= 0)
+    return 0; // Not discharging (external power)
+
+  float charge = max(0.0f, (sy - slope * sx) / n + slope * (n - 1));
+  float wakesLeft = charge / perWake;
+  float days = (deadline - now) / 86400.0f;
+  float spare = wakesLeft / days - scheduledPerDay;
+  Logger::logf(Logger::LOG_DEBUG,
+               "Battery: %.1f%% left, %.2f%% per wake, %.0f wakes for %.1f "
+               "days (%u scheduled a day)",
+               charge * 100.0f, perWake * 100.0f, wakesLeft, days,
+               (unsigned)scheduledPerDay);
+
+  if (spare <= 86400.0f / BATTERY_MAX_INTERVAL)
+    return BATTERY_MAX_INTERVAL;
+  return (uint32_t)(86400.0f / spare);
+}
+} // namespace BatteryHistory
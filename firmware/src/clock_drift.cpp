@@ -0,0 +1,178 @@
+#include "clock_drift.h"
+#include "logger.h"
+
+#include <esp_attr.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CLOCK_DRIFT_MAGIC 0x44524654 // "DRFT"
+
+// PCF85063 offset register steps (ppm): mode 0 corrects every 2 hours,
+// mode 1 every 4 minutes
+#define TRIM_STEP_NORMAL 4.34f
+#define TRIM_STEP_COURSE 4.069f
+
+// Any epoch before this was read from a clock that hasn't been set
+#define CLOCK_VALID_EPOCH 1577836800 // 2020-01-01
+
+namespace ClockDrift {
+// What is known about the RTC, kept across deep sleep
+struct State {
+  uint32_t magic;
+  uint32_t lastSync;  // Epoch the RTC was last set to
+  float driftPpm;     // Untrimmed drift, positive = RTC runs fast
+  float weight;       // Sum of measurement weights (0 = no measurement)
+  bool trimMode;      // Offset register mode in effect
+  int8_t trimValue;   // Offset register value in effect
+  char tz[64];        // POSIX TZ rule in effect ("" = none yet)
+  char zone[40];      // Timezone it was looked up for ("" = from config)
+  uint32_t tzFetched; // Epoch of the lookup (0 = before the clock was set)
+};
+
+RTC_DATA_ATTR static State state;
+
+// Drift the offset register currently removes (ppm)
+static float trimPpm() {
+  return state.trimValue *
+         (state.trimMode ? TRIM_STEP_COURSE : TRIM_STEP_NORMAL);
+}
+
+// Spread of the drift estimate (ppm)
+static float uncertaintyPpm() {
+  return state.weight > 0 ? 1.0f / sqrtf(state.weight)
+                          : CLOCK_DRIFT_DEFAULT_PPM;
+}
+
+// Seconds the RTC may be off by, 'since' seconds after the last sync
+static float predictedError(uint32_t since) {
+  float residual = state.weight > 0 ? fabsf(state.driftPpm - trimPpm()) : 0;
+  return CLOCK_DRIFT_BASE_ERROR +
+         (residual + uncertaintyPpm()) * since / 1000000.0f;
+}
+
+// Apply the trim and restore the clocks from the RTC
+void begin(Inkplate &display) {
+  if (state.magic != CLOCK_DRIFT_MAGIC) {
+    state = {};
+    state.magic = CLOCK_DRIFT_MAGIC;
+#if defined(RTC_OFFSET_MODE) && defined(RTC_OFFSET_VALUE)
+    state.trimMode = RTC_OFFSET_MODE;
+    state.trimValue = RTC_OFFSET_VALUE;
+#endif
+  }
+
+  display.rtcSetClockOffset(state.trimMode, state.trimValue);
+  Logger::logf(Logger::LOG_DEBUG,
+               "RTC trim: mode %d, value %d (drift %.1f +/- %.1f ppm)",
+               state.trimMode, state.trimValue, state.driftPpm,
+               uncertaintyPpm());
+
+  if (!display.rtcIsSet())
+    return;
+
+  // The system clock drifts a lot more than the RTC over deep sleep, and
+  // TLS certificate checks read it
+  struct timeval now = {(time_t)display.rtcGetEpoch(), 0};
+  settimeofday(&now, nullptr);
+  if (state.tz[0]) {
+    setenv("TZ", state.tz, 1);
+    tzset();
+  }
+}
+
+// Whether NTP should run this wake
+bool syncDue(Inkplate &display, const AppConfig::Ntp &ntp) {
+  if (!display.rtcIsSet() || !state.lastSync || !state.tz[0]) {
+    Logger::log(Logger::LOG_DEBUG, "NTP due: no previous sync.");
+    return true;
+  }
+
+  uint32_t now = display.rtcGetEpoch();
+  uint32_t since = now > state.lastSync ? now - state.lastSync : 0;
+  float error = predictedError(since);
+  if (now < state.lastSync || since >= ntp.maxInterval ||
+      error > ntp.maxError) {
+    Logger::logf(Logger::LOG_DEBUG,
+                 "NTP due: last sync %u s ago, predicted error %.1f s.", since,
+                 error);
+    return true;
+  }
+
+  Logger::logf(Logger::LOG_INFO,
+               "NTP skipped: last sync %u s ago, predicted error %.1f s.",
+               since, error);
+  return false;
+}
+
+// Remember the TZ rule NTPFetch applied
+void setTimezone(const char *rule, const char *zone, time_t now) {
+  // Written from the NTP job; nothing reads it again until the next wake
+  if (strlen(zone) >= sizeof(state.zone))
+    zone = ""; // Wouldn't match when looked up
+  if (strcmp(rule, state.tz) != 0 || strcmp(zone, state.zone) != 0)
+    Logger::logf(Logger::LOG_INFO, "Timezone rule: %s", rule);
+  strlcpy(state.tz, rule, sizeof(state.tz));
+  strlcpy(state.zone, zone, sizeof(state.zone));
+  state.tzFetched = now >= CLOCK_VALID_EPOCH ? now : 0;
+}
+
+// The rule looked up for 'zone', while it is fresh
+const char *timezoneRule(const char *zone, time_t now, uint32_t maxAge) {
+  if (!zone[0] || !state.tz[0] || strcmp(zone, state.zone) != 0 ||
+      !state.tzFetched || now < (time_t)state.tzFetched ||
+      now - state.tzFetched >= maxAge)
+    return nullptr;
+  return state.tz;
+}
+
+// Fold a sync into the drift estimate and retune the RTC
+void recordSync(Inkplate &display, time_t rtcBefore,
+                const struct timeval &ntpNow, time_t written) {
+  uint32_t span = state.lastSync && ntpNow.tv_sec > (time_t)state.lastSync
+                      ? ntpNow.tv_sec - state.lastSync
+                      : 0;
+  if (rtcBefore && span >= CLOCK_DRIFT_MIN_SPAN) {
+    // The RTC shows whole seconds; on average it is half way into the one
+    // it reads
+    double error =
+        (rtcBefore + 0.5) - (ntpNow.tv_sec + ntpNow.tv_usec / 1000000.0);
+    float measured = error / span * 1000000.0 + trimPpm();
+
+    // Anything this large means the RTC was disturbed, not drifting
+    if (fabsf(measured) < 500.0f) {
+      // Weight by precision (the read error over the span), halving the
+      // weight of older measurements so the estimate follows aging and
+      // temperature
+      float sigma = CLOCK_DRIFT_BASE_ERROR * 1000000.0f / span;
+      float weight = 1.0f / (sigma * sigma);
+      float previous = state.weight * 0.5f;
+      state.driftPpm =
+          (state.driftPpm * previous + measured * weight) / (previous + weight);
+      state.weight = previous + weight;
+
+      Logger::logf(Logger::LOG_INFO,
+                   "RTC drift: %.2f s over %u s (%.1f ppm), estimate %.1f "
+                   "+/- %.1f ppm",
+                   error, span, measured, state.driftPpm, uncertaintyPpm());
+    }
+  }
+  state.lastSync = written;
+
+  // A rule looked up before the clock was set is dated by this sync
+  if (state.zone[0] && !state.tzFetched)
+    state.tzFetched = written;
+
+#if CLOCK_DRIFT_AUTO_TRIM
+  if (state.weight > 0) {
+    long value = lroundf(state.driftPpm / TRIM_STEP_NORMAL);
+    state.trimMode = false;
+    state.trimValue = (int8_t)constrain(value, -64L, 63L);
+  }
+#endif
+
+  // Setting the RTC resets its offset register
+  display.rtcSetClockOffset(state.trimMode, state.trimValue);
+}
+} // namespace ClockDrift
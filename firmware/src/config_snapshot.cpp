@@ -0,0 +1,282 @@
+#include "config_snapshot.h"
+
+#define FS_NO_GLOBALS
+#include <FS.h>
+#ifdef FILE_READ
+#undef FILE_READ
+#endif
+#ifdef FILE_WRITE
+#undef FILE_WRITE
+#endif
+
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <rom/crc.h>
+#include <stddef.h>
+
+#include "definitions.h"
+#include "logger.h"
+#include "networking.h"
+#include "trace.h"
+
+#define CONFIG_SNAPSHOT_MAGIC 0x43464731 // "CFG1"
+
+namespace ConfigSnapshot {
+// Calls fn(field) for every string field
+template <typename F> static void forEachString(AppConfig &c, F fn) {
+  fn(c.api);
+  fn(c.configVersion);
+  fn(c.security.caCertPath);
+  fn(c.mqtt.server);
+  fn(c.mqtt.user);
+  fn(c.mqtt.pass);
+  fn(c.mqtt.device);
+  fn(c.mqtt.topic);
+  fn(c.ntp.server1);
+  fn(c.ntp.server2);
+  fn(c.ntp.timezone);
+  fn(c.ntp.basepath);
+  fn(c.ntp.posix);
+  fn(c.renderer.basepath);
+  fn(c.renderer.defaultEndpoint);
+  fn(c.renderer.button);
+  fn(c.renderer.sleepStart);
+  fn(c.renderer.sleepStop);
+  fn(c.renderer.interval);
+  fn(c.renderer.minRuntime);
+  for (uint16_t i = 0; i < c.renderer.wakeCount; i++) {
+    fn(c.renderer.wakes[i].time);
+    fn(c.renderer.wakes[i].endpoint);
+  }
+}
+
+// CRC32 of the fields after 'crc' and the used part of the pool
+static uint32_t checksum(const AppConfig &c) {
+  const uint8_t *start = (const uint8_t *)&c.poolUsed;
+  const uint8_t *end = (const uint8_t *)c.pool + c.poolUsed;
+  return crc32_le(0, start, end - start);
+}
+
+// Bytes of the snapshot file
+static size_t fileSize(const AppConfig &c) {
+  return offsetof(AppConfig, pool) + c.poolUsed;
+}
+
+// Turn pool offsets into pointers; false if one points outside the pool
+static bool relocate(AppConfig &c) {
+  bool ok = c.poolUsed > 0 && c.poolUsed <= CONFIG_STRING_POOL &&
+            c.pool[c.poolUsed - 1] == '\0';
+  forEachString(c, [&](const char *&field) {
+    uintptr_t offset = (uintptr_t)field;
+    if (offset >= c.poolUsed)
+      ok = false;
+    field = ok && offset ? c.pool + offset : nullptr;
+  });
+  return ok;
+}
+
+// Copies strings into the pool while building. Fields hold offsets until
+// relocate(); offset 0 stands for nullptr.
+class Pool {
+public:
+  explicit Pool(AppConfig &c) : _c(c) {
+    _c.pool[0] = '\0';
+    _c.poolUsed = 1;
+  }
+
+  const char *add(const char *s) {
+    if (!s)
+      return nullptr;
+    size_t len = strlen(s) + 1;
+    if (_c.poolUsed + len > CONFIG_STRING_POOL) {
+      _full = true;
+      return nullptr;
+    }
+    uint32_t offset = _c.poolUsed;
+    memcpy(_c.pool + offset, s, len);
+    _c.poolUsed += len;
+    return (const char *)(uintptr_t)offset;
+  }
+
+  bool full() const { return _full; }
+
+private:
+  AppConfig &_c;
+  bool _full = false;
+};
+
+// Fill 'c' from the parsed JSON, applying the same defaults the firmware
+// used when reading the document directly
+static esp_err_t build(JsonDocument &doc, AppConfig &c) {
+  Pool pool(c);
+
+  c.api = pool.add(doc["api"].as<const char *>());
+  c.configVersion = pool.add(doc["version"].as<String>().c_str());
+
+  JsonVariant security = doc["security"];
+  c.security.allowInsecure = security["allowInsecure"] | false;
+  c.security.caCertPath =
+      pool.add(security["caCertPath"] | CA_CERT_FILE_PATH);
+
+  JsonVariant mqtt = doc["mqtt"];
+  c.mqtt.enabled = mqtt.is<JsonObject>() && mqtt["enabled"].as<bool>();
+  c.mqtt.tls = mqtt["tls"] | false;
+  c.mqtt.trace = mqtt["trace"] | false;
+  c.mqtt.port = mqtt["port"] | 1883;
+  c.mqtt.retries = mqtt["retries"] | 3;
+  c.mqtt.maxtx = mqtt["maxtx"] | MQTT_MAX_PACKET_SIZE;
+  c.mqtt.maxrx = mqtt["maxrx"] | MQTT_MAX_PACKET_SIZE;
+  c.mqtt.server = pool.add(mqtt["server"] | "");
+  c.mqtt.user = pool.add(mqtt["user"] | "");
+  c.mqtt.pass = pool.add(mqtt["pass"] | "");
+  c.mqtt.device = pool.add(mqtt["device"] | "inky");
+  c.mqtt.topic = pool.add(mqtt["topic"] | "inky-renderer");
+
+  JsonVariant ntp = doc["ntp"];
+  c.ntp.enabled = ntp.is<JsonObject>() && ntp["enabled"].as<bool>();
+  c.ntp.retries = ntp["retries"] | 3;
+  c.ntp.gmtOffset = ntp["gmtoffset"] | 0;
+  c.ntp.daylightOffset = ntp["daylightoffset"] | 0;
+  c.ntp.maxError = ntp["maxerror"] | 5;
+  c.ntp.maxInterval = ntp["maxinterval"] | 604800;
+  c.ntp.server1 = pool.add(ntp["server1"] | "time.cloudflare.com");
+  c.ntp.server2 = pool.add(ntp["server2"] | "pool.ntp.org");
+  c.ntp.timezone = pool.add(ntp["timezone"] | "America/Los_Angeles");
+  c.ntp.basepath = pool.add(ntp["basepath"] | "/api/v0/timezone");
+  c.ntp.posix = pool.add(ntp["posix"] | "");
+
+  JsonVariant renderer = doc["renderer"];
+  AppConfig::Renderer &r = c.renderer;
+  r.cleardisplay = renderer["cleardisplay"].as<bool>();
+  r.compression = renderer["compression"] | true;
+  r.prefetch = renderer["prefetch"] | false;
+  r.framecache = renderer["framecache"] | true;
+  r.offlineRotate = strcmp(renderer["offline"] | "rotate", "last") != 0;
+  r.retries = renderer["retries"] | 3;
+  r.timeout = renderer["timeout"] | 30;
+  r.readsize = renderer["readsize"] | READSTREAM_READ_SIZE;
+  r.prefetchMaxAge = renderer["prefetchmaxage"] | 86400;
+  r.maxDefer = renderer["maxdefer"] | 86400;
+  r.basepath = pool.add(renderer["basepath"] | "/api/v1");
+  r.defaultEndpoint = pool.add(renderer["default"].as<const char *>());
+  r.button = pool.add(renderer["button"].as<const char *>());
+  r.sleepStart = pool.add(renderer["sleepwindow"]["start"] | "");
+  r.sleepStop = pool.add(renderer["sleepwindow"]["stop"] | "");
+  r.interval = pool.add(renderer["wake-interval"] | "");
+  r.minRuntime = pool.add(renderer["minruntime"] | "");
+
+  r.wakeCount = 0;
+  for (JsonPair kv : renderer["wakes"].as<JsonObject>()) {
+    if (r.wakeCount == CONFIG_MAX_WAKES) {
+      Logger::logf(Logger::LOG_WARNING, "Only the first %d wakes are used.",
+                   CONFIG_MAX_WAKES);
+      break;
+    }
+    WakeSlot &slot = r.wakes[r.wakeCount++];
+    slot.time = pool.add(kv.key().c_str());
+    slot.endpoint = pool.add(kv.value().as<const char *>());
+  }
+
+  return pool.full() ? ESP_ERR_NO_MEM : ESP_OK;
+}
+
+// Read a snapshot built from the given config.json; false if there is none
+// or it doesn't match
+static bool readSnapshot(AppConfig &c, uint32_t sourceCrc,
+                         uint32_t sourceSize) {
+  if (!LittleFS.exists(CONFIG_SNAPSHOT_PATH))
+    return false;
+
+  fs::File file = LittleFS.open(CONFIG_SNAPSHOT_PATH, "r");
+  size_t size = file ? file.size() : 0;
+  bool ok = size >= offsetof(AppConfig, pool) && size <= sizeof(AppConfig) &&
+            file.read((uint8_t *)&c, size) == size;
+  if (file)
+    file.close();
+
+  ok = ok && c.magic == CONFIG_SNAPSHOT_MAGIC &&
+       c.version == CONFIG_SNAPSHOT_VERSION && c.size == sizeof(AppConfig) &&
+       c.sourceCrc == sourceCrc && c.sourceSize == sourceSize &&
+       c.renderer.wakeCount <= CONFIG_MAX_WAKES && fileSize(c) == size &&
+       c.crc == checksum(c);
+  return ok && relocate(c);
+}
+
+// Write the snapshot (before relocate(), while fields hold offsets)
+static void writeSnapshot(const AppConfig &c) {
+  fs::File file = LittleFS.open(CONFIG_SNAPSHOT_PATH, "w");
+  if (!file)
+    return;
+  size_t size = fileSize(c);
+  size_t written = file.write((const uint8_t *)&c, size);
+  file.close();
+
+  if (written != size) {
+    Logger::log(Logger::LOG_WARNING, "Config snapshot write failed.");
+    LittleFS.remove(CONFIG_SNAPSHOT_PATH);
+  } else {
+    Logger::logf(Logger::LOG_DEBUG, "Config snapshot written (%u bytes).",
+                 size);
+  }
+}
+
+// Load 'path' into a newly allocated AppConfig
+esp_err_t load(const char *path, AppConfig *&config) {
+  TRACE_ZONE("config");
+  config = nullptr;
+
+  fs::File file = LittleFS.open(path, "r");
+  size_t size = file ? file.size() : 0;
+  if (size == 0 || size > CONFIG_MAX_SOURCE) {
+    if (file)
+      file.close();
+    return size == 0 ? ESP_ERR_NOT_FOUND : ESP_ERR_NO_MEM;
+  }
+
+  // The file is read either way to tell whether it changed
+  char *source = (char *)ps_malloc(size);
+  AppConfig *c = (AppConfig *)ps_calloc(1, sizeof(AppConfig));
+  bool ok = source && c && file.read((uint8_t *)source, size) == size;
+  file.close();
+  if (!ok) {
+    free(source);
+    free(c);
+    return ESP_ERR_NO_MEM;
+  }
+  uint32_t sourceCrc = crc32_le(0, (const uint8_t *)source, size);
+
+  if (readSnapshot(*c, sourceCrc, size)) {
+    free(source);
+    config = c;
+    Logger::log(Logger::LOG_DEBUG, "Config loaded from snapshot.");
+    return ESP_OK;
+  }
+
+  // New or changed config: parse it once and keep the result
+  memset(c, 0, sizeof(AppConfig));
+  esp_err_t err;
+  {
+    JsonDocument doc;
+    err = deserializeJson(doc, (const char *)source, size)
+              ? ESP_ERR_INVALID_ARG
+              : build(doc, *c);
+  }
+  free(source);
+  if (err != ESP_OK) {
+    free(c);
+    return err;
+  }
+
+  c->magic = CONFIG_SNAPSHOT_MAGIC;
+  c->version = CONFIG_SNAPSHOT_VERSION;
+  c->size = sizeof(AppConfig);
+  c->sourceCrc = sourceCrc;
+  c->sourceSize = size;
+  c->crc = checksum(*c);
+  writeSnapshot(*c);
+  relocate(*c);
+
+  config = c;
+  return ESP_OK;
+}
+} // namespace ConfigSnapshot
@@ -0,0 +1,189 @@
+#include "dns_cache.h"
+#include "logger.h"
+#include "tls_utils.h"
+
+#include <WiFiClientSecure.h>
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <lwip/netdb.h>
+#include <time.h>
+
+namespace DNSCache {
+// One cached lookup
+struct Entry {
+  char host[DNS_CACHE_HOST_LEN];
+  uint32_t ip;
+  uint32_t resolvedAt; // time(NULL) of the lookup
+  uint32_t ttl;        // Seconds
+};
+
+RTC_DATA_ATTR static Entry entries[DNS_CACHE_ENTRIES];
+
+// The table is shared with the network worker tasks
+static portMUX_TYPE cacheMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Seconds since the entry was resolved (UINT32_MAX if the clock went back)
+static uint32_t age(const Entry &e, uint32_t now) {
+  return now >= e.resolvedAt ? now - e.resolvedAt : UINT32_MAX;
+}
+
+// Index of the entry for 'host', or -1
+static int find(const char *host) {
+  for (int i = 0; i < DNS_CACHE_ENTRIES; i++)
+    if (entries[i].host[0] && strcmp(entries[i].host, host) == 0)
+      return i;
+  return -1;
+}
+
+// Blocking lookup through lwIP (thread safe, unlike hostByName)
+static bool lookup(const char *host, IPAddress &ip) {
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+
+  struct addrinfo *res = nullptr;
+  if (lwip_getaddrinfo(host, nullptr, &hints, &res) != 0 || !res)
+    return false;
+
+  ip = IPAddress(((struct sockaddr_in *)res->ai_addr)->sin_addr.s_addr);
+  lwip_freeaddrinfo(res);
+  return true;
+}
+
+// Store a lookup, replacing the same host or else the oldest entry
+static void store(const char *host, const IPAddress &ip) {
+  uint32_t now = time(NULL);
+
+  portENTER_CRITICAL(&cacheMux);
+  int slot = find(host);
+  if (slot < 0) {
+    slot = 0;
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+      if (!entries[i].host[0]) {
+        slot = i;
+        break;
+      }
+      if (age(entries[i], now) > age(entries[slot], now))
+        slot = i;
+    }
+  }
+
+  Entry &e = entries[slot];
+  strncpy(e.host, host, sizeof(e.host) - 1);
+  e.host[sizeof(e.host) - 1] = '\0';
+  e.ip = (uint32_t)ip;
+  e.resolvedAt = now;
+  e.ttl = DNS_CACHE_TTL;
+  portEXIT_CRITICAL(&cacheMux);
+}
+
+// Resolve a hostname, from the cache when possible
+bool resolve(const char *host, IPAddress &ip) {
+  if (!host || !host[0])
+    return false;
+
+  // Nothing to look up for IP literals
+  if (ip.fromString(host))
+    return true;
+
+  bool cacheable = strlen(host) < DNS_CACHE_HOST_LEN;
+  if (cacheable) {
+    uint32_t now = time(NULL);
+    bool hit = false;
+
+    portENTER_CRITICAL(&cacheMux);
+    int i = find(host);
+    if (i >= 0 && age(entries[i], now) < entries[i].ttl) {
+      ip = IPAddress(entries[i].ip);
+      hit = true;
+    }
+    portEXIT_CRITICAL(&cacheMux);
+
+    if (hit) {
+      Logger::logf(Logger::LOG_DEBUG, "DNS cache hit: %s -> %s", host,
+                   ip.toString().c_str());
+      return true;
+    }
+  }
+
+  unsigned long start = millis();
+  if (!lookup(host, ip)) {
+    Logger::logf(Logger::LOG_ERROR, "DNS lookup failed: %s", host);
+    return false;
+  }
+
+  Logger::logf(Logger::LOG_DEBUG, "DNS lookup: %s -> %s (%lu ms)", host,
+               ip.toString().c_str(), millis() - start);
+  if (cacheable)
+    store(host, ip);
+  return true;
+}
+
+// Forget a hostname
+void invalidate(const char *host) {
+  if (!host)
+    return;
+
+  portENTER_CRITICAL(&cacheMux);
+  int i = find(host);
+  if (i >= 0)
+    entries[i].host[0] = '\0';
+  portEXIT_CRITICAL(&cacheMux);
+}
+
+// Re-resolve entries that would expire before the next wake is done with them
+void refresh(time_t nextWake) {
+  for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+    char host[DNS_CACHE_HOST_LEN];
+    uint32_t now = time(NULL);
+    bool due = false;
+
+    portENTER_CRITICAL(&cacheMux);
+    const Entry &e = entries[i];
+    if (e.host[0]) {
+      uint32_t a = age(e, now);
+      uint64_t expires = (uint64_t)e.resolvedAt + e.ttl;
+      due = a < e.ttl && expires < (uint64_t)nextWake + DNS_CACHE_MARGIN;
+      memcpy(host, e.host, sizeof(host));
+    }
+    portEXIT_CRITICAL(&cacheMux);
+
+    IPAddress ip;
+    if (due && lookup(host, ip)) {
+      Logger::logf(Logger::LOG_DEBUG, "DNS refreshed: %s -> %s", host,
+                   ip.toString().c_str());
+      store(host, ip);
+    }
+  }
+}
+
+// Plain TCP connector
+bool connect(Client &client, const char *host, uint16_t port,
+             unsigned long &resolvedAt) {
+  IPAddress ip;
+  if (!resolve(host, ip))
+    return false;
+  resolvedAt = millis();
+  if (client.connect(ip, port))
+    return true;
+
+  // The address may have moved; try once more with a fresh lookup
+  invalidate(host);
+  return resolve(host, ip) && client.connect(ip, port);
+}
+
+// TLS connector (the client must be a configured WiFiClientSecure)
+bool connectSecure(Client &client, const char *host, uint16_t port,
+                   unsigned long &resolvedAt) {
+  WiFiClientSecure &secure = static_cast<WiFiClientSecure &>(client);
+  IPAddress ip;
+  if (!resolve(host, ip))
+    return false;
+  resolvedAt = millis();
+  if (TLSConnect(secure, ip, port, host))
+    return true;
+
+  invalidate(host);
+  return resolve(host, ip) && TLSConnect(secure, ip, port, host);
+}
+} // namespace DNSCache
@@ -0,0 +1,153 @@
+#include "energy.h"
+#include "board_traits.h"
+#include "logger.h"
+
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <time.h>
+
+namespace Energy {
+// One wake
+struct Record {
+  uint32_t wake;  // Wake counter
+  uint32_t epoch; // time(NULL) when the wake ended
+  uint32_t awakeMs;
+  uint32_t radioMs;   // WiFi on
+  uint32_t refreshMs; // Panel refreshing
+  uint16_t refreshes;
+  uint16_t cpuMhz; // Average CPU clock over the wake
+  uint32_t bytesSent;
+  uint32_t bytesReceived;
+  uint32_t sleepSeconds; // Deep sleep that followed
+  uint32_t awakeUah;     // Estimated charge while awake
+  uint32_t sleepUah;     // ...and during the sleep
+  bool published;
+};
+
+RTC_DATA_ATTR static uint32_t wakeCount = 0;
+RTC_DATA_ATTR static Record ring[ENERGY_RING_SIZE];
+RTC_DATA_ATTR static uint8_t ringHead = 0;
+
+// This wake so far
+static Record current;
+static uint32_t radioSince = 0; // millis() the radio came on (0 = off)
+static uint32_t clockSince = 0; // millis() of the last clock change
+static uint32_t clockMhz = 0;   // Clock since then
+static uint64_t mhzMs = 0;      // Integral of the clock over time (MHz x ms)
+static bool finished = false;
+
+// Counters are updated from the network worker tasks
+static portMUX_TYPE energyMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Fold the time at the current clock into the integral (call locked)
+static void accumulateClock(uint32_t now) {
+  mhzMs += (uint64_t)clockMhz * (now - clockSince);
+  clockSince = now;
+}
+
+// Logs one record, stamped with the time its wake ended
+static void logRecord(const Record &r) {
+  Logger::logf(Logger::LOG_INFO,
+               "Energy: awake=%u radio=%u refresh=%u/%u cpu=%u tx=%u rx=%u "
+               "sleep=%u uah=%u+%u at=%u",
+               r.awakeMs, r.radioMs, r.refreshMs, r.refreshes, r.cpuMhz,
+               r.bytesSent, r.bytesReceived, r.sleepSeconds, r.awakeUah,
+               r.sleepUah, r.epoch);
+}
+
+// Start a new wake
+void begin() {
+  wakeCount++;
+  current = {};
+  current.wake = wakeCount;
+  clockSince = 0; // The clock has been running since boot
+  clockMhz = getCpuFrequencyMhz();
+}
+
+// The radio was turned on or off
+void radio(bool on) {
+  uint32_t now = millis();
+  portENTER_CRITICAL(&energyMux);
+  if (on && !radioSince) {
+    radioSince = now ? now : 1;
+  } else if (!on && radioSince) {
+    current.radioMs += now - radioSince;
+    radioSince = 0;
+  }
+  portEXIT_CRITICAL(&energyMux);
+}
+
+// A panel refresh finished
+void refresh(uint32_t ms) {
+  portENTER_CRITICAL(&energyMux);
+  current.refreshMs += ms;
+  current.refreshes++;
+  portEXIT_CRITICAL(&energyMux);
+}
+
+// The CPU clock changed
+void cpuFrequency(uint32_t mhz) {
+  uint32_t now = millis();
+  portENTER_CRITICAL(&energyMux);
+  accumulateClock(now);
+  clockMhz = mhz;
+  portEXIT_CRITICAL(&energyMux);
+}
+
+// Bytes sent and received by a request
+void addBytes(uint32_t sent, uint32_t received) {
+  portENTER_CRITICAL(&energyMux);
+  current.bytesSent += sent;
+  current.bytesReceived += received;
+  portEXIT_CRITICAL(&energyMux);
+}
+
+// Close this wake's record with the board's current model
+void finish(uint32_t sleepSeconds) {
+  if (finished)
+    return;
+  finished = true;
+
+  uint32_t now = millis();
+  portENTER_CRITICAL(&energyMux);
+  accumulateClock(now);
+  if (radioSince)
+    current.radioMs += now - radioSince;
+  radioSince = 0;
+  Record r = current;
+  uint64_t clock = mhzMs;
+  portEXIT_CRITICAL(&energyMux);
+
+  r.epoch = time(NULL);
+  r.awakeMs = now;
+  r.cpuMhz = now ? clock / now : clockMhz;
+  r.sleepSeconds = sleepSeconds;
+
+  // mA x ms / 3600 = uAh
+  double awake = BOARD_CPU_BASE_MA * (double)r.awakeMs +
+                 BOARD_CPU_MA_PER_MHZ * (double)clock +
+                 BOARD_RADIO_MA * (double)r.radioMs +
+                 BOARD_REFRESH_MA * (double)r.refreshMs;
+  r.awakeUah = awake / 3600.0 +
+               BOARD_UAH_PER_KB * (r.bytesSent + r.bytesReceived) / 1024.0;
+  r.sleepUah = BOARD_SLEEP_UA * (double)sleepSeconds / 3600.0;
+  r.published = false;
+
+  ring[ringHead] = r;
+  ringHead = (ringHead + 1) % ENERGY_RING_SIZE;
+
+  Logger::logf(Logger::LOG_DEBUG, "Energy: ~%u uAh awake, %u uAh asleep.",
+               r.awakeUah, r.sleepUah);
+}
+
+// Log unpublished records from earlier wakes
+void publishBacklog() {
+  for (int i = 0; i < ENERGY_RING_SIZE; i++) {
+    Record &r = ring[(ringHead + i) % ENERGY_RING_SIZE];
+    if (r.wake == 0 || r.published)
+      continue;
+    logRecord(r);
+    r.published = true;
+  }
+}
+} // namespace Energy
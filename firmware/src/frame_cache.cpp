@@ -0,0 +1,262 @@
+#include "frame_cache.h"
+
+#define FS_NO_GLOBALS
+#include <FS.h>
+#ifdef FILE_READ
+#undef FILE_READ
+#endif
+#ifdef FILE_WRITE
+#undef FILE_WRITE
+#endif
+
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+
+#include "logger.h"
+#include "psram_allocator.h"
+
+namespace FrameCache {
+// 32-bit FNV-1a, used to spot frames that are already cached
+static uint32_t fnv1a(const uint8_t *data, size_t len) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++)
+    hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
+
+// PackBits: a header n < 128 is followed by n + 1 literal bytes, n > 128 by
+// one byte repeated 257 - n times. Flat backgrounds, text and dashboards
+// shrink a lot; dithered photos barely do.
+static void pack(const uint8_t *in, size_t len, PsramVector &out) {
+  out.clear();
+  out.reserve(len + len / 128 + 1);
+
+  size_t i = 0;
+  while (i < len) {
+    size_t run = 1;
+    while (i + run < len && run < 128 && in[i + run] == in[i])
+      run++;
+    if (run >= 3) {
+      out.push_back((uint8_t)(257 - run));
+      out.push_back(in[i]);
+      i += run;
+      continue;
+    }
+
+    // Literals, up to the next run worth encoding
+    size_t start = i;
+    size_t count = 0;
+    while (i < len && count < 128) {
+      if (i + 2 < len && in[i] == in[i + 1] && in[i] == in[i + 2])
+        break;
+      i++;
+      count++;
+    }
+    out.push_back((uint8_t)(count - 1));
+    out.insert(out.end(), in + start, in + start + count);
+  }
+}
+
+// Reverse of pack(); false unless it fills 'out' exactly
+static bool unpack(const uint8_t *in, size_t len, uint8_t *out,
+                   size_t outLen) {
+  size_t i = 0, o = 0;
+  while (i < len) {
+    uint8_t header = in[i++];
+    if (header < 128) {
+      size_t n = header + 1;
+      if (i + n > len || o + n > outLen)
+        return false;
+      memcpy(out + o, in + i, n);
+      i += n;
+      o += n;
+    } else if (header > 128) {
+      size_t n = 257 - header;
+      if (i >= len || o + n > outLen)
+        return false;
+      memset(out + o, in[i++], n);
+      o += n;
+    }
+  }
+  return o == outLen;
+}
+
+// Path of the file holding a slot's frame
+static String slotPath(int slot) { return "/frame" + String(slot) + ".bin"; }
+
+// Load the index; an empty one if it is missing or unreadable
+static JsonArray loadIndex(JsonDocument &index) {
+  if (LittleFS.exists(FRAME_CACHE_INDEX_PATH)) {
+    fs::File file = LittleFS.open(FRAME_CACHE_INDEX_PATH, "r");
+    if (deserializeJson(index, file))
+      index.clear();
+    file.close();
+  }
+  if (!index["frames"].is<JsonArray>())
+    return index["frames"].to<JsonArray>();
+  return index["frames"].as<JsonArray>();
+}
+
+static bool saveIndex(const JsonDocument &index) {
+  fs::File file = LittleFS.open(FRAME_CACHE_INDEX_PATH, "w");
+  if (!file)
+    return false;
+  bool ok = serializeJson(index, file) > 0;
+  file.close();
+  return ok;
+}
+
+// Drop an entry and its file
+static void evict(JsonArray frames, size_t i) {
+  String path = slotPath(frames[i]["slot"] | 0);
+  if (LittleFS.exists(path))
+    LittleFS.remove(path);
+  frames.remove(i);
+}
+
+// Whether an entry already uses 'slot'
+static bool slotTaken(JsonArray frames, int slot) {
+  for (JsonObject f : frames)
+    if ((f["slot"] | -1) == slot)
+      return true;
+  return false;
+}
+
+// Save the frame buffer as the image rendered for 'endpoint'
+bool store(Inkplate &display, const char *endpoint, int rotation) {
+  const uint8_t *frame = display.DMemory4Bit;
+  if (!endpoint || !frame)
+    return false;
+
+  JsonDocument index;
+  JsonArray frames = loadIndex(index);
+  uint32_t seq = (index["seq"] | 0) + 1;
+  index["seq"] = seq;
+
+  // Already cached: only its position in the LRU order changes
+  uint32_t hash = fnv1a(frame, FRAME_CACHE_FRAME_BYTES);
+  for (JsonObject f : frames) {
+    if (f["hash"] == hash && f["rot"] == rotation &&
+        strcmp(f["endpoint"] | "", endpoint) == 0) {
+      f["used"] = seq;
+      return saveIndex(index);
+    }
+  }
+
+  PsramVector packed;
+  pack(frame, FRAME_CACHE_FRAME_BYTES, packed);
+  if (packed.size() > FRAME_CACHE_MAX_BYTES) {
+    Logger::logf(Logger::LOG_DEBUG,
+                 "Frame not cached: %u bytes packed (budget %u).",
+                 packed.size(), FRAME_CACHE_MAX_BYTES);
+    return false;
+  }
+
+  // Evict least recently used frames until this one fits
+  while (true) {
+    size_t cached = 0;
+    for (JsonObject f : frames)
+      cached += f["size"] | 0;
+    size_t freeBytes = LittleFS.totalBytes() - LittleFS.usedBytes();
+    if (frames.size() < FRAME_CACHE_ENTRIES &&
+        cached + packed.size() <= FRAME_CACHE_MAX_BYTES &&
+        packed.size() + FRAME_CACHE_FS_RESERVE <= freeBytes)
+      break;
+
+    if (frames.size() == 0) {
+      Logger::logf(Logger::LOG_WARNING,
+                   "Frame not cached: %u bytes won't fit (%u free).",
+                   packed.size(), freeBytes);
+      saveIndex(index);
+      return false;
+    }
+
+    size_t lru = 0;
+    for (size_t i = 1; i < frames.size(); i++)
+      if ((frames[i]["used"] | 0u) < (frames[lru]["used"] | 0u))
+        lru = i;
+    evict(frames, lru);
+  }
+
+  int slot = 0;
+  while (slotTaken(frames, slot))
+    slot++;
+
+  // Frame first, so the index never points at a partial file
+  fs::File file = LittleFS.open(slotPath(slot), "w");
+  if (!file)
+    return false;
+  size_t written = file.write(packed.data(), packed.size());
+  file.close();
+  if (written != packed.size()) {
+    Logger::log(Logger::LOG_ERROR, "Frame cache write failed.");
+    LittleFS.remove(slotPath(slot));
+    return false;
+  }
+
+  JsonObject f = frames.add<JsonObject>();
+  f["slot"] = slot;
+  f["endpoint"] = endpoint;
+  f["hash"] = hash;
+  f["rot"] = rotation;
+  f["size"] = packed.size();
+  f["used"] = seq;
+
+  Logger::logf(Logger::LOG_DEBUG, "Frame cached: %s (%u bytes packed).",
+               endpoint, packed.size());
+  return saveIndex(index);
+}
+
+// Load a cached frame into the frame buffer
+bool show(Inkplate &display, int rotation, bool rotate) {
+  uint8_t *frame = display.DMemory4Bit;
+  if (!frame)
+    return false;
+
+  JsonDocument index;
+  JsonArray frames = loadIndex(index);
+  uint32_t seq = (index["seq"] | 0) + 1;
+
+  while (true) {
+    // Oldest shown when rotating, otherwise the newest
+    int pick = -1;
+    for (size_t i = 0; i < frames.size(); i++) {
+      if (frames[i]["rot"] != rotation)
+        continue;
+      uint32_t used = frames[i]["used"] | 0u;
+      uint32_t best = pick < 0 ? 0 : (frames[pick]["used"] | 0u);
+      if (pick < 0 || (rotate ? used < best : used > best))
+        pick = i;
+    }
+    if (pick < 0) {
+      saveIndex(index);
+      return false;
+    }
+
+    JsonObject f = frames[pick];
+    fs::File file = LittleFS.open(slotPath(f["slot"] | 0), "r");
+    PsramVector packed;
+    bool ok = file && file.size() == (f["size"] | 0u);
+    if (ok) {
+      packed.resize(file.size());
+      ok = file.read(packed.data(), packed.size()) == packed.size() &&
+           unpack(packed.data(), packed.size(), frame,
+                  FRAME_CACHE_FRAME_BYTES);
+    }
+    if (file)
+      file.close();
+
+    if (ok) {
+      Logger::logf(Logger::LOG_INFO, "Showing cached frame: %s",
+                   f["endpoint"] | "");
+      f["used"] = seq;
+      index["seq"] = seq;
+      saveIndex(index);
+      return true;
+    }
+
+    Logger::log(Logger::LOG_WARNING, "Dropping unreadable cached frame.");
+    evict(frames, pick);
+  }
+}
+} // namespace FrameCache
@@ -0,0 +1,305 @@
+#include "inflater.h"
+#include "logger.h"
+
+#include <esp32/rom/miniz.h>
+
+namespace {
+// Optional gzip header fields (RFC 1952)
+constexpr uint8_t GZIP_FHCRC = 0x02;
+constexpr uint8_t GZIP_FEXTRA = 0x04;
+constexpr uint8_t GZIP_FNAME = 0x08;
+constexpr uint8_t GZIP_FCOMMENT = 0x10;
+
+// Appends decompressed output to a PsramVector
+void appendToVector(void *ctx, const uint8_t *data, size_t len) {
+  PsramVector *out = static_cast<PsramVector *>(ctx);
+  out->insert(out->end(), data, data + len);
+}
+
+// Allocate in PSRAM, falling back to internal RAM
+void *allocBuffer(size_t size) {
+  void *p = ps_malloc(size);
+  return p ? p : malloc(size);
+}
+} // namespace
+
+Inflater::Inflater()
+    : _state(nullptr), _window(nullptr), _windowPos(0), _flags(0),
+      _format(Format::GZIP), _stage(Stage::DONE), _frameLen(0), _gzipFlags(0),
+      _skip(0), _totalIn(0), _totalOut(0) {}
+
+Inflater::~Inflater() { end(); }
+
+// Map a Content-Encoding header value to a format
+bool Inflater::formatFor(const String &contentEncoding, Format &format) {
+  if (contentEncoding.equalsIgnoreCase("gzip") ||
+      contentEncoding.equalsIgnoreCase("x-gzip")) {
+    format = Format::GZIP;
+    return true;
+  }
+  if (contentEncoding.equalsIgnoreCase("deflate")) {
+    format = Format::DEFLATE;
+    return true;
+  }
+  return false;
+}
+
+// Allocate the window and reset state
+bool Inflater::begin(Format format) {
+  end();
+
+  _state = allocBuffer(sizeof(tinfl_decompressor));
+  _window = static_cast<uint8_t *>(allocBuffer(TINFL_LZ_DICT_SIZE));
+  if (!_state || !_window) {
+    Logger::log(Logger::LOG_ERROR, "Inflater: out of memory");
+    end();
+    return false;
+  }
+
+  tinfl_init(static_cast<tinfl_decompressor *>(_state));
+  _windowPos = 0;
+  _flags = TINFL_FLAG_HAS_MORE_INPUT;
+  _format = format;
+  _stage = (format == Format::GZIP) ? Stage::GZIP_HEADER : Stage::DEFLATE_PROBE;
+  _frameLen = 0;
+  _gzipFlags = 0;
+  _skip = 0;
+  _totalIn = 0;
+  _totalOut = 0;
+  return true;
+}
+
+// Release the window and decompressor state
+void Inflater::end() {
+  free(_state);
+  free(_window);
+  _state = nullptr;
+  _window = nullptr;
+}
+
+// Decompress input, passing output to the sink
+bool Inflater::write(const uint8_t *data, size_t len, Sink sink, void *ctx) {
+  if (!active())
+    return false;
+
+  _totalIn += len;
+  while (len > 0) {
+    size_t used;
+    if (_stage == Stage::DONE)
+      return true; // Ignore anything after the end of the stream
+    if (_stage == Stage::FAILED)
+      return false;
+
+    if (_stage == Stage::BODY) {
+      // The byte the deflate probe held back goes in first
+      if (_frameLen) {
+        _frameLen = 0;
+        if (inflateBody(_frame, 1, sink, ctx) < 0) {
+          Logger::log(Logger::LOG_ERROR, "Inflater: corrupt stream");
+          _stage = Stage::FAILED;
+          return false;
+        }
+        continue;
+      }
+
+      int n = inflateBody(data, len, sink, ctx);
+      if (n < 0) {
+        Logger::log(Logger::LOG_ERROR, "Inflater: corrupt stream");
+        _stage = Stage::FAILED;
+        return false;
+      }
+      // No progress; wait for more input. The body can also end without
+      // using any of it, and then the rest is the trailer.
+      if (n == 0 && _stage == Stage::BODY)
+        return true;
+      used = n;
+    } else {
+      used = consumeFraming(data, len);
+    }
+
+    data += used;
+    len -= used;
+  }
+  return _stage != Stage::FAILED;
+}
+
+// Decompress input, appending output to a vector
+bool Inflater::write(const uint8_t *data, size_t len, PsramVector &out) {
+  return write(data, len, appendToVector, &out);
+}
+
+// Move to the next optional gzip header field (or the body)
+void Inflater::advanceHeader() {
+  _frameLen = 0;
+  if (_gzipFlags & GZIP_FEXTRA) {
+    _gzipFlags &= ~GZIP_FEXTRA;
+    _stage = Stage::GZIP_XLEN;
+  } else if (_gzipFlags & GZIP_FNAME) {
+    _gzipFlags &= ~GZIP_FNAME;
+    _stage = Stage::GZIP_NAME;
+  } else if (_gzipFlags & GZIP_FCOMMENT) {
+    _gzipFlags &= ~GZIP_FCOMMENT;
+    _stage = Stage::GZIP_COMMENT;
+  } else if (_gzipFlags & GZIP_FHCRC) {
+    _gzipFlags &= ~GZIP_FHCRC;
+    _skip = 2;
+    _stage = Stage::GZIP_HCRC;
+  } else {
+    _stage = Stage::BODY;
+  }
+}
+
+// Consume gzip header/trailer bytes or probe for a zlib header
+size_t Inflater::consumeFraming(const uint8_t *data, size_t len) {
+  size_t used = 0;
+
+  while (used < len) {
+    switch (_stage) {
+    // Fixed 10-byte header: magic, method, flags, mtime, xfl, os
+    case Stage::GZIP_HEADER:
+      _frame[_frameLen++] = data[used++];
+      if (_frameLen < 10)
+        break;
+      if (_frame[0] != 0x1f || _frame[1] != 0x8b || _frame[2] != 8) {
+        Logger::log(Logger::LOG_ERROR, "Inflater: bad gzip header");
+        _stage = Stage::FAILED;
+        return used;
+      }
+      _gzipFlags = _frame[3];
+      advanceHeader();
+      break;
+
+    // Length of the extra field (little endian)
+    case Stage::GZIP_XLEN:
+      _frame[_frameLen++] = data[used++];
+      if (_frameLen < 2)
+        break;
+      _skip = _frame[0] | (_frame[1] << 8);
+      _stage = Stage::GZIP_EXTRA;
+      if (_skip == 0)
+        advanceHeader();
+      break;
+
+    // Skipped fields (extra data, header CRC)
+    case Stage::GZIP_EXTRA:
+    case Stage::GZIP_HCRC: {
+      size_t n = min(_skip, len - used);
+      used += n;
+      _skip -= n;
+      if (_skip == 0)
+        advanceHeader();
+      break;
+    }
+
+    // Zero-terminated file name / comment
+    case Stage::GZIP_NAME:
+    case Stage::GZIP_COMMENT:
+      if (data[used++] == 0)
+        advanceHeader();
+      break;
+
+    // "deflate" is usually zlib-wrapped, but some servers send raw deflate.
+    // A zlib header is CMF (method 8, window <= 32KB) and FLG, with CMF*256 +
+    // FLG a multiple of 31; raw deflate rarely passes all three. Nothing is
+    // consumed, unless the first write holds a single byte: that one is kept
+    // and fed to the body first.
+    case Stage::DEFLATE_PROBE: {
+      if (_frameLen == 0 && len - used < 2) {
+        _frame[_frameLen++] = data[used++];
+        return used;
+      }
+      uint8_t cmf = _frameLen ? _frame[0] : data[used];
+      uint8_t flg = _frameLen ? data[used] : data[used + 1];
+      if ((cmf & 0x0F) == 8 && (cmf >> 4) <= 7 && ((cmf << 8) | flg) % 31 == 0)
+        _flags |= TINFL_FLAG_PARSE_ZLIB_HEADER;
+      _stage = Stage::BODY;
+      return used;
+    }
+
+    // CRC32 + ISIZE
+    case Stage::GZIP_TRAILER:
+      _frame[_frameLen++] = data[used++];
+      if (_frameLen < 8)
+        break;
+      checkTrailer();
+      return used;
+
+    default:
+      return used;
+    }
+
+    // Hand control back once the body starts
+    if (_stage == Stage::BODY)
+      return used;
+  }
+  return used;
+}
+
+// The ROM's tinfl reads whole bytes ahead into its bit buffer and doesn't
+// hand them back at the end of the stream (newer miniz does), so the start
+// of the gzip trailer can be sitting there. Bits left of the last byte of
+// the deflate data are padding; whole bytes after them are the trailer.
+void Inflater::takeReadAhead() {
+  tinfl_decompressor *r = static_cast<tinfl_decompressor *>(_state);
+  uint32_t bits = r->m_num_bits;
+  uint64_t buf = (uint64_t)r->m_bit_buf >> (bits & 7);
+  for (bits -= bits & 7; bits >= 8 && _frameLen < 8; bits -= 8) {
+    _frame[_frameLen++] = buf & 0xFF;
+    buf >>= 8;
+  }
+  if (_frameLen == 8)
+    checkTrailer();
+}
+
+// Check the gzip trailer's ISIZE against what we produced
+void Inflater::checkTrailer() {
+  uint32_t isize = _frame[4] | (_frame[5] << 8) | (_frame[6] << 16) |
+                   ((uint32_t)_frame[7] << 24);
+  if (isize != (uint32_t)_totalOut) {
+    Logger::logf(Logger::LOG_ERROR, "Inflater: size mismatch (%u != %u)",
+                 isize, (uint32_t)_totalOut);
+    _stage = Stage::FAILED;
+  } else {
+    _stage = Stage::DONE;
+  }
+}
+
+// Run the decompressor over body bytes, draining the window into the sink
+int Inflater::inflateBody(const uint8_t *data, size_t len, Sink sink,
+                          void *ctx) {
+  tinfl_decompressor *r = static_cast<tinfl_decompressor *>(_state);
+  size_t used = 0;
+
+  while (true) {
+    size_t inBytes = len - used;
+    size_t outBytes = TINFL_LZ_DICT_SIZE - _windowPos;
+    tinfl_status status =
+        tinfl_decompress(r, data + used, &inBytes, _window,
+                         _window + _windowPos, &outBytes, _flags);
+    used += inBytes;
+
+    if (outBytes > 0) {
+      sink(ctx, _window + _windowPos, outBytes);
+      _totalOut += outBytes;
+    }
+    _windowPos = (_windowPos + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+    if (status < TINFL_STATUS_DONE)
+      return -1;
+
+    // End of the deflate stream; gzip still has its trailer
+    if (status == TINFL_STATUS_DONE) {
+      _frameLen = 0;
+      _stage = (_format == Format::GZIP) ? Stage::GZIP_TRAILER : Stage::DONE;
+      if (_format == Format::GZIP)
+        takeReadAhead();
+      return used;
+    }
+
+    // Out of input; wait for the next write()
+    if (status == TINFL_STATUS_NEEDS_MORE_INPUT)
+      return used;
+
+    // TINFL_STATUS_HAS_MORE_OUTPUT: the window wrapped, keep draining
+  }
+}
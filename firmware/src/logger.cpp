@@ -5,6 +5,9 @@
 
 #include <Arduino.h>
 #include <Inkplate.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <freertos/semphr.h>
 #include <stdarg.h>
 
 #ifdef ARDUINO_INKPLATE10V2
@@ -24,6 +27,28 @@ static Stream *stream = nullptr;
 static Inkplate *display = nullptr;
 static PubSubClient *mqttClient = nullptr;
 static String mqttTopic = "innky/logs";
+static bool mqttConnected = false;
+
+// Serializes logging from the main loop and network worker tasks
+static SemaphoreHandle_t logMutex = nullptr;
+
+// Holds the log mutex for the current scope (recursive, so nested calls
+// like log() -> flushMQTT() are fine)
+struct LogLock {
+  LogLock() {
+    if (logMutex)
+      xSemaphoreTakeRecursive(logMutex, portMAX_DELAY);
+  }
+  ~LogLock() {
+    if (logMutex)
+      xSemaphoreGiveRecursive(logMutex);
+  }
+};
+
+// Clock base captured from the RTC; timestamps are extrapolated with millis()
+static bool clockSet = false;
+static time_t clockEpoch = 0;
+static unsigned long clockMillis = 0;
 
 // Queue to store log messages before sending to MQTT
 // This guarantees zero heap fragmentation from the queue structure itself.
@@ -33,6 +58,17 @@ static int queueHead = 0; // Write index
 static int queueTail = 0; // Read index
 static int queueCount = 0;
 
+// Lines logged after MQTT was shut down, NUL separated, for the next wake
+RTC_DATA_ATTR static char rtcLog[LOG_RTC_BUFFER];
+RTC_DATA_ATTR static uint16_t rtcLogLength = 0;
+RTC_DATA_ATTR static uint16_t rtcLogDropped = 0; // Lines that didn't fit
+
+// Wakes left that don't wait for the broker's echo
+RTC_DATA_ATTR static uint8_t syncSkip = 0;
+
+// Set once cleanup() has shut MQTT down for this wake
+static bool mqttClosed = false;
+
 // Decompresses PackBits RLE data from PROGMEM to a RAM buffer
 void decompressRLE(const uint8_t *in, size_t inLen, uint8_t *out,
                    size_t outLen) {
@@ -73,9 +109,23 @@ void enqueueLog(const String &logMessage) {
   }
 }
 
+// Keeps a log line in RTC memory for the next wake (call locked)
+static void persistLog(const String &logMessage) {
+  size_t len = logMessage.length() + 1;
+  if (rtcLogLength > sizeof(rtcLog))
+    rtcLogLength = 0; // Garbage after a cold boot
+  if (rtcLogLength + len > sizeof(rtcLog)) {
+    rtcLogDropped++;
+    return;
+  }
+  memcpy(rtcLog + rtcLogLength, logMessage.c_str(), len);
+  rtcLogLength += len;
+}
+
 // Sends all queued log messages via MQTT
 void flushMQTT() {
-  if (!mqttClient || !mqttClient->connected())
+  LogLock lock;
+  if (!mqttClient || !mqttConnected || !mqttClient->connected())
     return;
 
   while (queueCount > 0) {
@@ -92,6 +142,37 @@ void flushMQTT() {
   }
 }
 
+// Print sink that only counts what is written to it
+class CountingPrint : public Print {
+public:
+  size_t count = 0;
+  size_t write(uint8_t) override {
+    count++;
+    return 1;
+  }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    count += size;
+    return size;
+  }
+};
+
+// Streams a large payload straight to the MQTT client
+bool publishStream(const char *suffix,
+                   const std::function<void(Print &)> &write) {
+  LogLock lock;
+  if (!mqttClient || !mqttConnected || !mqttClient->connected())
+    return false;
+
+  CountingPrint counter;
+  write(counter);
+
+  String topic = mqttTopic + suffix;
+  if (!mqttClient->beginPublish(topic.c_str(), counter.count, false))
+    return false;
+  write(*mqttClient);
+  return mqttClient->endPublish() == 1;
+}
+
 // Waits until all log messages are sent or timeout occurs
 void waitForFlush(unsigned long timeoutMs) {
   if (!mqttClient)
@@ -99,33 +180,171 @@ void waitForFlush(unsigned long timeoutMs) {
 
   unsigned long start = millis();
   while (queueCount > 0 && millis() - start < timeoutMs) {
-    mqttClient->loop();
-    flushMQTT();
+    {
+      LogLock lock;
+      if (!mqttConnected)
+        break;
+      mqttClient->loop();
+      flushMQTT();
+    }
     delay(5);
   }
 }
 
-// Cleans up the logger by flushing and disconnecting MQTT
+// Publishes a marker to a topic we subscribe to and waits for the broker to
+// send it back. Logs go out at QoS 0, so nothing acknowledges them; the echo
+// can only arrive after everything published before it was received. The
+// topic sits beside the log topic rather than under it, so the markers
+// don't show up for whoever follows <topic>/#. PubSubClient doesn't report
+// the SUBACK, so a refused subscription only shows as a missing echo.
+static bool syncMQTT(unsigned long timeoutMs) {
+  char token[12];
+  snprintf(token, sizeof(token), "%08x", (unsigned)esp_random());
+  String topic = mqttTopic + "-sync";
+  volatile bool echoed = false;
+
+  {
+    LogLock lock;
+    if (!mqttClient || !mqttConnected || !mqttClient->connected())
+      return false;
+
+    mqttClient->setCallback([&](char *t, uint8_t *payload, unsigned int len) {
+      if (topic == t && len == strlen(token) &&
+          memcmp(payload, token, len) == 0)
+        echoed = true;
+    });
+    if (!mqttClient->subscribe(topic.c_str()) ||
+        !mqttClient->publish(topic.c_str(), token)) {
+      mqttClient->setCallback(nullptr);
+      return false;
+    }
+  }
+
+  unsigned long start = millis();
+  while (!echoed && millis() - start < timeoutMs) {
+    {
+      LogLock lock;
+      if (!mqttClient->loop())
+        break;
+    }
+    delay(5);
+  }
+
+  LogLock lock;
+  mqttClient->setCallback(nullptr);
+  return echoed;
+}
+
+// Cleans up the logger: flush the queue, wait for the broker to have it all,
+// then disconnect MQTT. timeoutMs bounds the whole sequence.
 void cleanup(unsigned long timeoutMs) {
+  unsigned long start = millis();
   waitForFlush(timeoutMs);
 
-  if (mqttClient)
+  unsigned long spent = millis() - start;
+  bool missed = false;
+  if (syncSkip) {
+    syncSkip--;
+  } else if (spent < timeoutMs && mqttConnected &&
+             !syncMQTT(timeoutMs - spent)) {
+    // Don't spend the whole wait on every wake if the echo never comes
+    missed = true;
+    syncSkip = LOG_SYNC_RETRY;
+  }
+
+  LogLock lock;
+  if (mqttClient && mqttConnected)
     mqttClient->disconnect();
+  mqttConnected = false;
+  mqttClosed = true;
+
+  // Whatever didn't go out waits for the next wake
+  while (queueCount > 0) {
+    persistLog(logQueue[queueTail]);
+    logQueue[queueTail] = String();
+    queueTail = (queueTail + 1) % MAX_LOG_QUEUE;
+    queueCount--;
+  }
+
+  // Logged now MQTT is closed, so the next wake publishes it
+  if (missed)
+    logf(LOG_WARNING,
+         "MQTT logs not confirmed by the broker; not waiting for the next "
+         "%d wakes.",
+         LOG_SYNC_RETRY);
+}
+
+// Publishes the lines the last wake kept in RTC memory
+void publishBacklog() {
+  LogLock lock;
+  if (!mqttClient || !mqttConnected || !mqttClient->connected())
+    return;
 
-  delay(500);
+  // Every line ends in a NUL; anything else is left from a cold boot
+  if (rtcLogLength > sizeof(rtcLog) ||
+      (rtcLogLength && rtcLog[rtcLogLength - 1] != '\0')) {
+    rtcLogLength = 0;
+    rtcLogDropped = 0;
+  }
+
+  size_t sent = 0;
+  while (sent < rtcLogLength) {
+    const char *line = rtcLog + sent;
+    if (!mqttClient->publish(mqttTopic.c_str(), line))
+      break; // The rest stays for the next wake
+    sent += strlen(line) + 1;
+  }
+  memmove(rtcLog, rtcLog + sent, rtcLogLength - sent);
+  rtcLogLength -= sent;
+
+  if (rtcLogDropped && !rtcLogLength) {
+    char note[64];
+    snprintf(note, sizeof(note), "Logger: %u lines from the last wake lost.",
+             (unsigned)rtcLogDropped);
+    rtcLogDropped = 0;
+    log(LOG_WARNING, note);
+  }
 }
 
 // Sets the MQTT client and topic for logging
 void setMQTTClient(PubSubClient &client, const char *topic) {
+  LogLock lock;
   mqttClient = &client;
   if (topic)
     mqttTopic = topic;
 }
 
+// Marks whether the MQTT client may be used for publishing
+void setMQTTConnected(bool connected) {
+  LogLock lock;
+  mqttConnected = connected;
+}
+
+// True while the logger is publishing to MQTT
+bool isMQTTConnected() {
+  LogLock lock;
+  return mqttConnected;
+}
+
 // Initializes the logger with a stream and an Inkplate display
 void init(Stream &s, Inkplate &d) {
+  if (!logMutex)
+    logMutex = xSemaphoreCreateRecursiveMutex();
+
   stream = &s;
   display = &d;
+
+  // Read the RTC once; everything after this is derived from millis()
+  if (d.rtcIsSet())
+    syncClock(d.rtcGetEpoch());
+}
+
+// Updates the timestamp base after the RTC has been (re)set
+void syncClock(time_t epoch) {
+  LogLock lock;
+  clockSet = true;
+  clockEpoch = epoch;
+  clockMillis = millis();
 }
 
 // Logs a message to the stream and optionally MQTT
@@ -138,9 +357,13 @@ void log(LogLevel level, const char *message) {
   char formattedLevel[10];
   snprintf(formattedLevel, sizeof(formattedLevel), "%-8s", levelName);
 
+  LogLock lock;
+
   // Generate timestamped log message
   String timestamp =
-      display->rtcIsSet() ? getLocalTimestamp(display->rtcGetEpoch()) : "";
+      clockSet ? getLocalTimestamp(clockEpoch +
+                                   (millis() - clockMillis) / 1000)
+               : "";
 
   // Build log entry
   String logEntry;
@@ -163,8 +386,11 @@ void log(LogLevel level, const char *message) {
   if (level <= LOG_LEVEL && stream)
     Serial.println(logEntry);
 
-  // Send to MQTT if enabled
-  if (mqttClient) {
+  // Send to MQTT if enabled, or keep it for the next wake once MQTT is shut
+  // down
+  if (mqttClient && mqttClosed) {
+    persistLog(logEntry);
+  } else if (mqttClient) {
     enqueueLog(logEntry);
     flushMQTT();
   }
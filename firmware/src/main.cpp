@@ -7,7 +7,6 @@
 #undef FILE_WRITE
 #endif
 
-#include <ArduinoJson.h>
 #include <ArduinoOTA.h>
 #include <ESPmDNS.h>
 #include <Inkplate.h>
@@ -15,11 +14,23 @@
 #include <esp_sleep.h>
 #include <map>
 
+#include "async_net.h"
 #include "battery.h"
+#include "battery_history.h"
+#include "clock_drift.h"
+#include "config_snapshot.h"
 #include "definitions.h"
+#include "dns_cache.h"
+#include "energy.h"
+#include "frame_cache.h"
 #include "logger.h"
+#include "net_metrics.h"
 #include "networking.h"
+#include "power_profile.h"
+#include "prefetch.h"
+#include "redirect_cache.h"
 #include "time_utils.h"
+#include "trace.h"
 #include "tls_utils.h"
 
 #ifdef ARDUINO_INKPLATE10V2
@@ -32,8 +43,8 @@ Inkplate display;
 // Define modes for clarity
 enum BootMode { MODE_NORMAL, MODE_WIFI_SETUP, MODE_MAINTENANCE };
 
-// Allocate the JSON document
-JsonDocument config;
+// Settings from config.json (nullptr until loaded)
+AppConfig *config = nullptr;
 
 // Misc settings and flags.
 int deepSleepTime = 3600; // (in seconds)
@@ -47,6 +58,17 @@ const char *deepSleepStartTime = "7:30am";
 RTC_DATA_ATTR bool hideSplashScreen = false;
 RTC_DATA_ATTR char nextWakeTime[10] = {0};
 
+// Next wake, once planned, and the job prefetching its image
+WakeEntry plannedWake;
+bool wakePlanned = false;
+WakeHints wakeHints = {};
+bool haveWakeHints = false;
+AsyncNet::Handle prefetchJob = nullptr;
+unsigned long prefetchTimeout = 0;
+
+// Set once the network has been shut down for this wake
+bool networkDown = false;
+
 // Draw battery percentage + render screen
 void draw(const bool render = true,
           int rotation = display.Adafruit_GFX::getRotation()) {
@@ -54,37 +76,144 @@ void draw(const bool render = true,
     Logger::onScreen(Logger::LOG_INFO, false, 0, rotation,
                      "Battery: %.2fv (%d%%)", batteryVoltage, batteryPercent);
 
-  if (render)
+  if (render) {
+    TRACE_ZONE("refresh");
+    PowerProfile::Boost boost(POWER_REFRESH_BOOST);
+    unsigned long start = millis();
     display.display();
+    Energy::refresh(millis() - start);
+  }
 }
 
-// Enter deep sleep mode
-void deepSleep(const bool render = true,
-               const JsonVariant &jsonRenderer = config["renderer"]) {
-  if (render)
-    draw(true);
+// Endpoint for a scheduled wake key (falls back to the default endpoint)
+const char *wakeEndpoint(const AppConfig::Renderer &renderer,
+                         const char *wakeTime) {
+  if (wakeTime && wakeTime[0])
+    for (uint16_t i = 0; i < renderer.wakeCount; i++)
+      if (strcmp(renderer.wakes[i].time, wakeTime) == 0)
+        return renderer.wakes[i].endpoint;
+  return renderer.defaultEndpoint;
+}
 
-  // Turn off display, not supported on Inkplate 6COLOR
-#ifdef ARDUINO_INKPLATE10V2
-  display.einkOff();
-#endif
+// Spacing of interval wakes the battery can afford (0 = as configured)
+uint32_t batteryInterval(const AppConfig::Renderer &renderer, time_t now) {
+  int runtime = renderer.minRuntime ? parseDuration(renderer.minRuntime) : 0;
+  if (runtime <= 0)
+    return 0;
+
+  uint32_t interval =
+      BatteryHistory::intervalFloor(now, runtime, renderer.wakeCount);
+  if (interval)
+    Logger::logf(Logger::LOG_INFO,
+                 "Battery budget: interval wakes at least %u s apart.",
+                 interval);
+  return interval;
+}
 
-  Logger::log(Logger::LOG_DEBUG, "Preparing to deep sleep...");
-  delay(1000);
-  esp_sleep_enable_ext0_wakeup(GPIO_NUM_36, LOW);
+// Work out the next RTC wake; false if the RTC or schedule isn't usable.
+// The result is kept, and only recalculated if it has since passed or
+// wakePlanned is cleared.
+bool planNextWake(const AppConfig::Renderer &renderer, WakeEntry &wake) {
+  if (!display.rtcIsSet())
+    return false;
+
+  uint32_t now = display.rtcGetEpoch();
+  if (!wakePlanned || plannedWake.epoch <= (time_t)now) {
+    String defaultEndpoint = renderer.defaultEndpoint
+                                 ? renderer.defaultEndpoint
+                                 : "/render/unsplash,wallhaven";
+
+    WakeHints hints = haveWakeHints ? wakeHints : WakeHints{};
+    hints.minInterval = batteryInterval(renderer, now);
+    plannedWake = calculateNextWake(now, renderer.sleepStart,
+                                    renderer.sleepStop, renderer.wakes,
+                                    renderer.wakeCount, defaultEndpoint,
+                                    renderer.interval, &hints);
+    wakePlanned = true;
+  }
+
+  wake = plannedWake;
+  return true;
+}
+
+// Turn the hints from a fetch into absolute times for planNextWake(),
+// deferring by at most 'maxDefer' seconds
+void setWakeHints(const FetchedImage &image, const char *endpoint,
+                  const char *wakeTime, uint32_t maxDefer) {
+  if (!display.rtcIsSet() || !endpoint)
+    return;
+
+  time_t now = display.rtcGetEpoch();
+  wakeHints = {};
+  wakeHints.endpoint = endpoint;
+  wakeHints.time = wakeTime;
+  if (image.retryAfter)
+    wakeHints.notBefore = now + min(image.retryAfter, maxDefer);
+  if (image.maxAge)
+    wakeHints.freshUntil = now + min(image.maxAge, maxDefer);
+  if (image.nextWake) {
+    // Between WAKE_HINT_MIN_SECONDS and 'maxDefer' from now
+    time_t wakeBy =
+        image.nextWake < 1000000000UL ? now + image.nextWake : image.nextWake;
+    wakeHints.wakeBy = constrain(wakeBy, now + WAKE_HINT_MIN_SECONDS,
+                                 now + (time_t)maxDefer);
+  }
+
+  haveWakeHints = wakeHints.notBefore || wakeHints.freshUntil ||
+                  wakeHints.wakeBy;
+  if (haveWakeHints)
+    Logger::logf(Logger::LOG_DEBUG,
+                 "Wake hints: max-age=%u retry-after=%u next-wake=%u",
+                 image.maxAge, image.retryAfter, image.nextWake);
+}
+
+// Start the network side of the end of the wake on a worker: the prefetch,
+// then the trace and 'status' (if set), then the logs and the radio. Logs
+// made after this are kept in RTC memory for the next wake.
+AsyncNet::Handle beginShutdown(const char *status) {
+  return AsyncNet::submit("shutdown", [status] {
+    // Let the prefetch finish first
+    if (prefetchJob) {
+      if (AsyncNet::finish(prefetchJob, prefetchTimeout) != ESP_OK)
+        Logger::log(Logger::LOG_WARNING, "Prefetch did not complete.");
+      prefetchJob = nullptr;
+    }
 
-  if (display.rtcIsSet() && jsonRenderer.is<JsonObject>()) {
-    JsonObject wakesObj = jsonRenderer["wakes"];
+    // Zones so far, plus the end of the last wake
+    if (config && config->mqtt.trace)
+      Trace::publish();
 
-    String sleepStart = jsonRenderer["sleepwindow"]["start"] | "";
-    String sleepStop = jsonRenderer["sleepwindow"]["stop"] | "";
-    String defaultEndpoint =
-        jsonRenderer["default"] | "/render/unsplash,wallhaven";
-    String intervalStr = jsonRenderer["wake-interval"] | "";
+    if (status)
+      Logger::publishStream("/status",
+                            [status](Print &out) { out.print(status); });
 
-    WakeEntry wake =
-        calculateNextWake(display.rtcGetEpoch(), sleepStart, sleepStop,
-                          wakesObj, defaultEndpoint, intervalStr);
+    Logger::cleanup(SHUTDOWN_MQTT_TIMEOUT);
+    return WifiShutdown(SHUTDOWN_WIFI_TIMEOUT);
+  });
+}
+
+// Longest the network shutdown may take
+unsigned long shutdownBudget() {
+  return prefetchTimeout + SHUTDOWN_MQTT_TIMEOUT + SHUTDOWN_WIFI_TIMEOUT +
+         1000;
+}
+
+// Wait for beginShutdown()
+void finishShutdown(AsyncNet::Handle shutdown) {
+  if (AsyncNet::finish(shutdown, shutdownBudget()) != ESP_OK)
+    Logger::log(Logger::LOG_WARNING, "Network shutdown incomplete.");
+  networkDown = true;
+}
+
+// Set the wakeup sources and the RTC alarm for the next wake. Returns the
+// seconds the sleep will last.
+uint32_t prepareSleep() {
+  Logger::log(Logger::LOG_DEBUG, "Preparing to deep sleep...");
+  esp_sleep_enable_ext0_wakeup(GPIO_NUM_36, LOW);
+
+  WakeEntry wake;
+  uint32_t sleepSeconds = 0;
+  if (config && planNextWake(config->renderer, wake)) {
     strncpy(nextWakeTime, wake.time.c_str(), sizeof(nextWakeTime) - 1);
     nextWakeTime[sizeof(nextWakeTime) - 1] = '\0';
 
@@ -96,6 +225,7 @@ void deepSleep(const bool render = true,
       Logger::log(Logger::LOG_ERROR, "RTC lost time! Re-syncing recommended.");
 
     display.rtcSetAlarmEpoch(wake.epoch, RTC_ALARM_MATCH_DHHMMSS);
+    sleepSeconds = max<time_t>(wake.epoch - (time_t)display.rtcGetEpoch(), 0);
 
     Logger::logf(Logger::LOG_INFO, "Next RTC Wake: %s, Endpoint: %s",
                  fmtEpoch(wake.epoch).c_str(), wake.endpoint.c_str());
@@ -104,14 +234,41 @@ void deepSleep(const bool render = true,
     Logger::logf(Logger::LOG_INFO, "RTC unset, sleeping %d seconds.",
                  deepSleepTime);
     esp_sleep_enable_timer_wakeup(deepSleepTime * uS_TO_S_FACTOR);
+    sleepSeconds = deepSleepTime;
   }
+  return sleepSeconds;
+}
+
+// Enter deep sleep mode. The wakeup sources are set first, so the device
+// wakes again whatever happens after. A wake that ends with the network
+// still up tears it down on a worker (on the other core) while the panel
+// refreshes; the wake ends when the slower of the two is done. Each step
+// waits for what it depends on (the refresh, the broker echoing the logs,
+// the AP disconnect) up to a deadline rather than for a fixed time.
+void deepSleep(const bool render = true) {
+  TRACE_BEGIN(sleep, "sleep");
+
+  uint32_t sleepSeconds = prepareSleep();
+
+  // The alarm has been logged by now, so it goes out with the rest
+  AsyncNet::Handle shutdown = networkDown ? nullptr : beginShutdown(nullptr);
 
-  delay(1000);
-  Logger::cleanup(5000);
-  WiFi.disconnect();
-  WiFi.mode(WIFI_OFF);
+  // display() returns once the refresh has finished
+  if (render)
+    draw(true);
 
-  delay(500);
+  // Then power the panel down (waits for its rails to drop). Not supported
+  // on Inkplate 6COLOR.
+#ifdef ARDUINO_INKPLATE10V2
+  display.einkOff();
+#endif
+
+  if (shutdown)
+    finishShutdown(shutdown);
+
+  Energy::finish(sleepSeconds);
+  Serial.flush();
+  TRACE_END(sleep);
   esp_deep_sleep_start();
 }
 
@@ -119,15 +276,19 @@ void setup() {
   // Initialize
   pinMode(39, INPUT_PULLUP);
   Serial.begin(115200);
-  display.begin();
+  Trace::begin();
+  {
+    TRACE_ZONE("display");
+    display.begin();
+  }
 
   // Read battery voltage at startup, store for more accurate logging
   batteryVoltage = display.readBattery();
   batteryPercent = getBatteryPercentage(batteryVoltage);
 
-#if defined(RTC_OFFSET_MODE) && defined(RTC_OFFSET_VALUE)
-  display.rtcSetClockOffset(RTC_OFFSET_MODE, RTC_OFFSET_VALUE);
-#endif
+  // Start associating now (after the battery read, so TX bursts don't sag it)
+  // and let the local setup below overlap with it; WifiConnect() picks it up
+  WifiBegin();
 
   display.rtcGetRtcData();
   display.rtcClearAlarmFlag();
@@ -139,6 +300,16 @@ void setup() {
 
   // Initialize logger
   Logger::init(Serial, display);
+  NetMetrics::begin();
+  Energy::begin();
+
+  // RTC trim, plus the system clock and timezone for wakes that skip NTP
+  ClockDrift::begin(display);
+
+  // Discharge history for the battery budget (the reading from before the
+  // radio started)
+  if (display.rtcIsSet())
+    BatteryHistory::record(display.rtcGetEpoch(), batteryVoltage);
 
   // Get rotation from display instead of build flag0
   int rotation = display.Adafruit_GFX::getRotation();
@@ -227,32 +398,27 @@ void setup() {
   }
 
   // Mount LittleFS
-  if (!LittleFS.begin(true)) {
+  TRACE_BEGIN(littlefs, "littlefs");
+  bool mounted = LittleFS.begin(true);
+  TRACE_END(littlefs);
+  if (!mounted) {
     Logger::onScreen(Logger::LOG_CRITICAL, true, 2, rotation,
                      "Failed to mount LittleFS!");
     deepSleep();
     return;
   }
 
-  // Load config.json
-  fs::File file = LittleFS.open(CONFIG_FILE_PATH, "r");
-  if (!file || file.size() == 0) {
+  // Load config.json, from its binary snapshot unless it has changed
+  esp_err_t configErr = ConfigSnapshot::load(CONFIG_FILE_PATH, config);
+  if (configErr == ESP_ERR_NOT_FOUND) {
     Logger::onScreen(Logger::LOG_CRITICAL, true, 2, rotation,
                      "Config file missing or empty!");
     deepSleep();
     return;
   }
 
-  // Get file size for logging
-  size_t fileSize = file.size();
-
-  // Deserialize directly from the file stream.
-  // This avoids allocating a temporary std::string buffer for the raw file.
-  DeserializationError error = deserializeJson(config, file);
-  file.close(); // Close immediately after parsing
-
   // Go to sleep if we failed to parse the config
-  if (error) {
+  if (configErr != ESP_OK) {
     Logger::onScreen(Logger::LOG_CRITICAL, true, 2, rotation,
                      "Failed to parse config.json!");
     deepSleep();
@@ -260,17 +426,15 @@ void setup() {
   }
 
   // Load TLS CA bundle for HTTPS/MQTT verification.
-  TLSLoadCACert(config.as<JsonVariant>());
+  TLSLoadCACert(config->security);
 
-  // Enable MQTT logging queue if MQTT is enabled
-  if (config["mqtt"]["enabled"] == true)
-    Logger::setMQTTClient(mqttClient,
-                          config["mqtt"]["topic"] | "inky-renderer");
+  // From here the wake mostly waits on the network and the panel, so drop
+  // the clock; the CPU bound phases raise it again
+  PowerProfile::begin();
 
-#if defined(RTC_OFFSET_MODE) && defined(RTC_OFFSET_VALUE)
-  Logger::logf(Logger::LOG_INFO, "RTC offset mode: %d, value: %d",
-               RTC_OFFSET_MODE, RTC_OFFSET_VALUE);
-#endif
+  // Enable MQTT logging queue if MQTT is enabled
+  if (config->mqtt.enabled)
+    Logger::setMQTTClient(mqttClient, config->mqtt.topic);
 
   // Print wakeup reason
   esp_sleep_wakeup_cause_t wakeup_reason = esp_sleep_get_wakeup_cause();
@@ -298,8 +462,7 @@ void setup() {
 
   // Log some basic information
   Logger::logf(Logger::LOG_DEBUG, "Config file: %s (bytes=%d, version=%s)",
-               CONFIG_FILE_PATH, fileSize,
-               config["version"].as<String>().c_str());
+               CONFIG_FILE_PATH, config->sourceSize, config->configVersion);
   if (!hideSplashScreen) {
     Logger::onScreen(Logger::LOG_INFO, true, 2, rotation,
                      "--- Inky Renderer (%s, v%s) ---", BUILD_TYPE,
@@ -319,7 +482,7 @@ void setup() {
   }
 
   // Verify API URL
-  const char *api = config["api"].as<const char *>();
+  const char *api = config->api;
   if (!api || strlen(api) == 0) {
     Logger::onScreen(Logger::LOG_CRITICAL, true, 2, rotation,
                      "API URL not specified!");
@@ -327,33 +490,132 @@ void setup() {
     return;
   }
 
+  // Go straight to where the API base was permanently moved, if it was
+  api = RedirectCache::apply(api);
+
+  // Determine endpoint: the button endpoint, or the one scheduled for this
+  // wake (the default if none was scheduled)
+  const AppConfig::Renderer &renderer = config->renderer;
+  const bool buttonWake =
+      wakeup_reason == ESP_SLEEP_WAKEUP_EXT0 && renderer.button;
+  const char *endpoint =
+      buttonWake ? renderer.button : wakeEndpoint(renderer, nextWakeTime);
+
+  // Draw the image the last wake prefetched for this one, while WiFi is
+  // still associating. Button wakes leave it for the scheduled wake.
+  const bool prefetch = renderer.prefetch;
+  const uint32_t prefetchMaxAge = renderer.prefetchMaxAge;
+
+  // Rendered frames are cached so a wake that can't fetch still shows one
+  const bool frameCache = renderer.framecache;
+  const bool offlineRotate = renderer.offlineRotate;
+  static FetchedImage image;
+  bool rendered = false;
+  if (prefetch && !buttonWake && endpoint &&
+      Prefetch::load(endpoint, prefetchMaxAge, image)) {
+    rendered = RenderImage(display, rotation, image) == ESP_OK;
+    if (rendered) {
+      if (frameCache)
+        FrameCache::store(display, endpoint, rotation);
+      showBattery = false;
+      draw();
+    }
+    image = FetchedImage();
+  }
+
   // Connect to WiFi
   if (WifiConnect(display, 30, false) != ESP_OK) {
+    // Keep the prefetched image on screen rather than an error
+    if (rendered) {
+      Logger::log(Logger::LOG_ERROR, "WiFi connection failed / timed out!");
+      deepSleep(false);
+      return;
+    }
+    // Or put up a cached frame
+    if (frameCache && FrameCache::show(display, rotation, offlineRotate)) {
+      Logger::log(Logger::LOG_ERROR, "WiFi connection failed / timed out!");
+      showBattery = false;
+      deepSleep();
+      return;
+    }
     Logger::onScreen(Logger::LOG_CRITICAL, true, 2, rotation,
                      "WiFi connection failed / timed out!");
     deepSleep();
     return;
   }
 
-  // Connect MQTT
-  if (config["mqtt"]["enabled"] && MqttConnect(config["mqtt"]) != ESP_OK) {
-    Logger::log(Logger::LOG_ERROR, "MQTT connection failed.");
-  } else {
-    Logger::log(Logger::LOG_INFO, "MQTT connected.");
-  }
+  // MQTT, NTP and the image fetch don't depend on each other, so run them
+  // concurrently on the network workers while we draw the standby screen.
+  AsyncNet::begin();
+  const int mqttRetries = config->mqtt.retries;
+  const int ntpRetries = config->ntp.retries;
+  const int fetchRetries = renderer.retries;
+  const int fetchTimeout = renderer.timeout;
 
-  // NTP synchronization
-  if (config["ntp"]["enabled"]) {
-    if (NTPSync(display, api, config["ntp"]) != ESP_OK)
-      Logger::log(Logger::LOG_ERROR, "NTP sync failed; using fallback timing.");
+  // Connect MQTT
+  AsyncNet::Handle mqttJob = nullptr;
+  if (config->mqtt.enabled)
+    mqttJob = AsyncNet::submit(
+        "mqtt", [] { return MqttConnect(config->mqtt); });
+
+  // NTP synchronization, once the RTC may have drifted past ntp.maxerror
+  // (the RTC itself is only written from setup())
+  AsyncNet::Handle ntpJob = nullptr;
+  if (config->ntp.enabled) {
+    if (ClockDrift::syncDue(display, config->ntp))
+      ntpJob = AsyncNet::submit(
+          "ntp", [api] { return NTPFetch(api, config->ntp); });
   } else {
     display.rtcReset();
     Logger::log(Logger::LOG_INFO, "NTP disabled; using hourly fallback.");
   }
 
+  // Fetch image (static so a job that outlives its deadline stays valid)
+  AsyncNet::Handle fetchJob = nullptr;
+  if (endpoint != nullptr && !rendered)
+    fetchJob = AsyncNet::submit("fetch", [rotation, api, endpoint] {
+      return FetchImage(rotation, api, config->renderer, endpoint, image,
+                        batteryPercent);
+    });
+
+  // The next wake as it stands. This plan predates the fetch's hints and
+  // any NTP correction; the alarm is planned again below.
+  WakeEntry wake;
+  const bool planned = planNextWake(renderer, wake);
+
+  // Download the next scheduled image alongside it, so both are done before
+  // the radio goes off. If the alarm lands on another endpoint, the
+  // prefetched image simply goes unused.
+  const unsigned long fetchBudget =
+      (fetchRetries * (fetchTimeout + 2) + 15) * 1000UL;
+  if (prefetch && endpoint != nullptr && planned) {
+    static FetchedImage nextImage;
+    static String nextEndpoint;
+    nextEndpoint = wakeEndpoint(renderer, wake.time.c_str());
+    prefetchTimeout = fetchBudget;
+    prefetchJob = AsyncNet::submit("prefetch", [rotation, api] {
+      esp_err_t err = FetchImage(rotation, api, config->renderer,
+                                 nextEndpoint.c_str(), nextImage,
+                                 batteryPercent);
+      if (err == ESP_OK && !Prefetch::store(nextEndpoint.c_str(), nextImage))
+        err = ESP_FAIL;
+      nextImage = FetchedImage();
+      return err;
+    });
+  }
+
+  // Refresh DNS entries that would expire before the next wake; nothing
+  // waits on this
+  const time_t nextWake =
+      planned ? wake.epoch : time(NULL) + (time_t)deepSleepTime;
+  AsyncNet::release(AsyncNet::submit("dns", [nextWake] {
+    DNSCache::refresh(nextWake);
+    return ESP_OK;
+  }));
+
   // If rendere.standby is set to true, display the loading image before pulling
   // the image from the renderer.
-  if (config["renderer"]["cleardisplay"]) {
+  if (renderer.cleardisplay && !rendered) {
     const char *psb = "Please Stand By";
     display.clearDisplay();
 #ifdef ARDUINO_INKPLATE10V2
@@ -396,17 +658,29 @@ void setup() {
   // we don't want to block the displayed content unless the battery is low.
   showBattery = false;
 
-  // Determine endpoint
-  const char *endpoint =
-      (wakeup_reason == ESP_SLEEP_WAKEUP_EXT0 &&
-       config["renderer"]["button"].as<const char *>())
-          ? config["renderer"]["button"]
-                .as<const char *>() // Render wake buton endpoint
-          : (strlen(nextWakeTime) > 0
-                 ? config["renderer"]["wakes"][nextWakeTime]
-                       .as<const char *>() // Render last wake endpoint
-                 : config["renderer"]["default"]
-                       .as<const char *>()); // Render default endpoint
+  // Wait for MQTT so the rest of this wake is published
+  if (mqttJob) {
+    if (AsyncNet::finish(mqttJob, mqttRetries * 16000UL) != ESP_OK) {
+      Logger::log(Logger::LOG_ERROR, "MQTT connection failed.");
+    } else {
+      Logger::log(Logger::LOG_INFO, "MQTT connected.");
+      Logger::publishBacklog();
+      NetMetrics::publishBacklog();
+      Energy::publishBacklog();
+    }
+  }
+
+  // Apply the NTP result to the RTC
+  if (ntpJob) {
+    esp_err_t synced =
+        AsyncNet::finish(ntpJob, (ntpRetries * 6 + 10) * 1000UL);
+    if (NTPCommit(display, synced) != ESP_OK)
+      Logger::log(Logger::LOG_ERROR,
+                  display.rtcIsSet()
+                      ? "NTP sync failed; keeping RTC time."
+                      : "NTP sync failed; using fallback timing.");
+  }
+
   if (endpoint == nullptr) {
     delay(5000); // WARN: Don't burn out the screen!
     Logger::onScreen(Logger::LOG_CRITICAL, true, 2, rotation,
@@ -415,13 +689,39 @@ void setup() {
     return;
   }
 
-  // Fetch and render image
-  if (DisplayImage(display, rotation, api, config["renderer"].as<JsonVariant>(),
-                   endpoint) != ESP_OK)
-    Logger::onScreen(Logger::LOG_ERROR, true, 2, rotation,
-                     "Image fetch/render failed!");
+  // Wait for the fetched image
+  esp_err_t fetched = ESP_OK;
+  if (!rendered) {
+    fetched = AsyncNet::finish(fetchJob, fetchBudget);
+
+    // The server can stretch or shorten the gap to the next wake
+    if (!buttonWake)
+      setWakeHints(image, endpoint, nextWakeTime, renderer.maxDefer);
+  }
+
+  // Plan the alarm afresh now that the hints and the NTP time are in
+  wakePlanned = false;
+
+  // That was the last of the network: wait for the prefetch, tell the
+  // broker, flush the logs and turn the radio off before the decode and
+  // refresh, which take seconds
+  finishShutdown(beginShutdown("rendering"));
+
+  // Render the fetched image
+  if (!rendered) {
+    if (fetched == ESP_OK && RenderImage(display, rotation, image) == ESP_OK) {
+      if (frameCache)
+        FrameCache::store(display, endpoint, rotation);
+    } else if (frameCache &&
+               FrameCache::show(display, rotation, offlineRotate)) {
+      Logger::log(Logger::LOG_ERROR, "Image fetch/render failed!");
+    } else {
+      Logger::onScreen(Logger::LOG_ERROR, true, 2, rotation,
+                       "Image fetch/render failed!");
+    }
+  }
 
-  deepSleep(true, config["renderer"]);
+  deepSleep(!rendered);
 }
 
 void loop() {
@@ -0,0 +1,101 @@
+#include "net_metrics.h"
+#include "energy.h"
+#include "logger.h"
+
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <time.h>
+
+namespace NetMetrics {
+// One request, as phase durations in milliseconds
+struct Record {
+  uint32_t wake;  // Wake counter
+  uint32_t epoch; // time(NULL) when recorded
+  char label[12];
+  int16_t code;
+  uint8_t redirects;
+  bool published;
+  uint16_t dns, connect, send, ttfb, headers, body, total;
+  uint32_t bytesSent;
+  uint32_t bytesReceived;
+};
+
+RTC_DATA_ATTR static uint32_t wakeCount = 0;
+RTC_DATA_ATTR static Record ring[NET_METRICS_RING_SIZE];
+RTC_DATA_ATTR static uint8_t ringHead = 0;
+
+// Records come from the network worker tasks
+static portMUX_TYPE ringMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Duration between two phase marks; 0 if the later phase wasn't reached
+static uint16_t span(uint32_t from, uint32_t to) {
+  if (to == 0 || to < from)
+    return 0;
+  return (uint16_t)min<uint32_t>(to - from, UINT16_MAX);
+}
+
+// Logs one record; backlog records carry the time they were taken
+static void logRecord(const Record &r, bool backlog) {
+  char at[20] = "";
+  if (backlog)
+    snprintf(at, sizeof(at), " at=%u", r.epoch);
+
+  Logger::logf(Logger::LOG_INFO,
+               "Net: %s code=%d dns=%u connect=%u send=%u ttfb=%u "
+               "headers=%u body=%u total=%u tx=%u rx=%u redirects=%u%s",
+               r.label, r.code, r.dns, r.connect, r.send, r.ttfb, r.headers,
+               r.body, r.total, r.bytesSent, r.bytesReceived, r.redirects, at);
+}
+
+// Start a new wake
+void begin() { wakeCount++; }
+
+// Record and log the phases of a request
+void record(const char *label, int code, const SimpleHTTP::Timing &t) {
+  Record r = {};
+  r.wake = wakeCount;
+  r.epoch = time(NULL);
+  strlcpy(r.label, label, sizeof(r.label));
+  r.code = code;
+  r.redirects = t.redirects;
+
+  // Each phase runs from the end of the previous one that was reached
+  r.dns = span(t.hopStart, t.resolved);
+  r.connect = span(t.resolved, t.connected);
+  r.send = span(t.connected, t.sent);
+  r.ttfb = span(t.sent, t.firstByte);
+  r.headers = span(t.firstByte, t.headers);
+  r.body = span(t.headers, t.body);
+  r.total = (uint16_t)min<uint32_t>(
+      max(max(t.body, t.headers), max(t.sent, t.connected)), UINT16_MAX);
+  r.bytesSent = t.bytesSent;
+  r.bytesReceived = t.bytesReceived;
+  Energy::addBytes(r.bytesSent, r.bytesReceived);
+
+  // Anything logged while MQTT is up goes out with this wake's logs
+  r.published = Logger::isMQTTConnected();
+
+  portENTER_CRITICAL(&ringMux);
+  ring[ringHead] = r;
+  ringHead = (ringHead + 1) % NET_METRICS_RING_SIZE;
+  portEXIT_CRITICAL(&ringMux);
+
+  logRecord(r, false);
+}
+
+// Log unpublished records from earlier wakes
+void publishBacklog() {
+  for (int i = 0; i < NET_METRICS_RING_SIZE; i++) {
+    Record r;
+    portENTER_CRITICAL(&ringMux);
+    Record &slot = ring[(ringHead + i) % NET_METRICS_RING_SIZE];
+    r = slot;
+    // This wake's records are already in the logger's MQTT queue
+    slot.published = true;
+    portEXIT_CRITICAL(&ringMux);
+
+    if (r.wake != 0 && r.wake != wakeCount && !r.published)
+      logRecord(r, true);
+  }
+}
+} // namespace NetMetrics
@@ -3,6 +3,7 @@
 #include <ESPmDNS.h>
 #include <Inkplate.h>
 #include <PubSubClient.h>
+#include <StreamString.h>
 #include <Update.h>
 #include <WebServer.h>
 #include <WiFi.h>
@@ -11,26 +12,71 @@
 #include <WiFiManager.h>
 #include <esp_err.h>
 #include <esp_partition.h>
+#include <esp_wifi.h>
+#include <freertos/event_groups.h>
+#include <lwip/sockets.h>
 #include <qrcode.h>
 #include <vector>
 
+#include "board_traits.h"
 #include "definitions.h"
+#include "dns_cache.h"
+#include "energy.h"
 #include "jpeg_utils.h"
 #include "logger.h"
+#include "net_metrics.h"
 #include "networking.h"
 #include "ota_html.h"
+#include "power_profile.h"
 #include "psram_allocator.h"
+#include "redirect_cache.h"
 #include "simplehttp.h"
 #include "tls_utils.h"
+#include "trace.h"
 #include "urlparser.h"
 
 // headers to collect from the HTTP response
 const char *displayHeaders[] = {
     "Content-Type",     "Content-Length",   "Transfer-Encoding",
-    "X-Image-Source",   "X-No-Dithering",   "X-Inky-Message-0",
-    "X-Inky-Message-1", "X-Inky-Message-2",
+    "Content-Encoding", "X-Image-Source",   "X-No-Dithering",
+    "X-Inky-Message-0", "X-Inky-Message-1", "X-Inky-Message-2",
+    "Cache-Control",    "Retry-After",      "X-Next-Wake",
 };
 
+// Reads the wake scheduling hints from a response
+static void readWakeHints(SimpleHTTP &https, FetchedImage &image) {
+  image.maxAge = 0;
+  image.retryAfter = 0;
+  image.nextWake = 0;
+
+  // Cache-Control: max-age=N (ignored alongside no-cache / no-store)
+  String cacheControl = https.header("Cache-Control");
+  cacheControl.toLowerCase();
+  long maxAge = -1;
+  bool noCache = false;
+  for (int start = 0; start <= (int)cacheControl.length();) {
+    int end = cacheControl.indexOf(',', start);
+    if (end < 0)
+      end = cacheControl.length();
+    String directive = cacheControl.substring(start, end);
+    directive.trim();
+    if (directive == "no-cache" || directive == "no-store")
+      noCache = true;
+    else if (directive.startsWith("max-age="))
+      maxAge = directive.substring(8).toInt();
+    start = end + 1;
+  }
+  if (maxAge > 0 && !noCache)
+    image.maxAge = maxAge;
+
+  // Retry-After: only the delta-seconds form is supported
+  if (https.hasHeader("Retry-After"))
+    image.retryAfter = max(0L, https.header("Retry-After").toInt());
+
+  if (https.hasHeader("X-Next-Wake"))
+    image.nextWake = max(0L, https.header("X-Next-Wake").toInt());
+}
+
 // Global network clients
 WiFiClient wifiClient;
 WiFiClientSecure wifiClientSecure;
@@ -39,6 +85,249 @@ PubSubClient mqttClient;
 // Global reference for the callback to access the display
 static Inkplate *_apDisplay = nullptr;
 
+// Link parameters from the last successful connection, kept across deep sleep
+// so the next wake can skip the channel scan and the DHCP exchange
+#define WIFI_CACHE_MAGIC 0x57464331 // "WFC1"
+struct WifiCache {
+  uint32_t magic;
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t leaseReuses; // Wakes since the lease was last refreshed by DHCP
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns1;
+  uint32_t dns2;
+};
+RTC_DATA_ATTR static WifiCache wifiCache = {0};
+
+// Remember the current link for the next wake
+static void wifiCacheStore(bool leaseReused) {
+  const uint8_t *bssid = WiFi.BSSID();
+  if (!bssid) {
+    wifiCache.magic = 0;
+    return;
+  }
+
+  memcpy(wifiCache.bssid, bssid, sizeof(wifiCache.bssid));
+  wifiCache.channel = WiFi.channel();
+  wifiCache.leaseReuses = leaseReused ? wifiCache.leaseReuses + 1 : 0;
+  wifiCache.ip = WiFi.localIP();
+  wifiCache.gateway = WiFi.gatewayIP();
+  wifiCache.subnet = WiFi.subnetMask();
+  wifiCache.dns1 = WiFi.dnsIP(0);
+  wifiCache.dns2 = WiFi.dnsIP(1);
+  wifiCache.magic = WIFI_CACHE_MAGIC;
+}
+
+// Point the station config at a specific AP (or back at any AP). Kept in RAM
+// so the credentials saved in NVS are never rewritten.
+static bool wifiPinAP(const uint8_t *bssid, uint8_t channel) {
+  wifi_config_t conf;
+  if (esp_wifi_get_config(WIFI_IF_STA, &conf) != ESP_OK ||
+      conf.sta.ssid[0] == 0)
+    return false;
+
+  conf.sta.bssid_set = bssid != nullptr;
+  if (bssid)
+    memcpy(conf.sta.bssid, bssid, sizeof(conf.sta.bssid));
+  conf.sta.channel = channel;
+
+  esp_wifi_set_storage(WIFI_STORAGE_RAM);
+  esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &conf);
+  esp_wifi_set_storage(WIFI_STORAGE_FLASH);
+  return err == ESP_OK;
+}
+
+// Station events the direct connect path waits on
+#define WIFI_LINK_UP_BIT BIT0
+#define WIFI_LINK_DOWN_BIT BIT1
+static EventGroupHandle_t wifiEvents = nullptr;
+
+// Mirrors station state into wifiEvents (runs on the system event task)
+static void wifiEventHandler(void *, esp_event_base_t base, int32_t id,
+                             void *) {
+  if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+    xEventGroupClearBits(wifiEvents, WIFI_LINK_DOWN_BIT);
+    xEventGroupSetBits(wifiEvents, WIFI_LINK_UP_BIT);
+  } else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+    xEventGroupClearBits(wifiEvents, WIFI_LINK_UP_BIT);
+    xEventGroupSetBits(wifiEvents, WIFI_LINK_DOWN_BIT);
+  }
+}
+
+// Create the event group and hook the station events (once)
+static bool wifiEventsInit() {
+  if (wifiEvents)
+    return true;
+
+  wifiEvents = xEventGroupCreate();
+  if (!wifiEvents)
+    return false;
+
+  esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED,
+                                      wifiEventHandler, nullptr, nullptr);
+  esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP,
+                                      wifiEventHandler, nullptr, nullptr);
+  return true;
+}
+
+// State of the association started by WifiBegin()
+static bool wifiStarted = false;     // An attempt is in flight (or finished)
+static bool wifiPinned = false;      // ...against the cached AP
+static bool wifiLeaseReused = false; // ...with the cached lease
+static unsigned long wifiStartMillis = 0;
+
+// Kick off one association attempt without waiting for it
+static bool wifiStartAttempt() {
+  xEventGroupClearBits(wifiEvents, WIFI_LINK_UP_BIT | WIFI_LINK_DOWN_BIT);
+  return esp_wifi_connect() == ESP_OK;
+}
+
+// Wait for the attempt in flight: true once we have an IP, false on a
+// disconnect or when the deadline passes (the attempt is then stopped)
+static bool wifiAwaitAttempt(unsigned long timeoutMs) {
+  const EventBits_t bits = WIFI_LINK_UP_BIT | WIFI_LINK_DOWN_BIT;
+  EventBits_t got = xEventGroupWaitBits(wifiEvents, bits, pdFALSE, pdFALSE,
+                                        pdMS_TO_TICKS(timeoutMs));
+  if (got & WIFI_LINK_UP_BIT)
+    return true;
+
+  // Still associating; stop it and let the disconnect event land before the
+  // next attempt clears the bits
+  if (!(got & WIFI_LINK_DOWN_BIT)) {
+    esp_wifi_disconnect();
+    xEventGroupWaitBits(wifiEvents, WIFI_LINK_DOWN_BIT, pdFALSE, pdFALSE,
+                        pdMS_TO_TICKS(250));
+  }
+  return false;
+}
+
+// Undo the pinning so later attempts can scan and use DHCP again
+static void wifiUnpin() {
+  if (wifiLeaseReused)
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+  if (wifiPinned)
+    wifiPinAP(nullptr, 0);
+  wifiPinned = false;
+  wifiLeaseReused = false;
+}
+
+// Starts joining the saved network in the background. Doesn't log, since it
+// runs before the logger is up.
+esp_err_t WifiBegin() {
+  if (wifiStarted)
+    return ESP_OK;
+
+  WiFi.mode(WIFI_STA);
+  Energy::radio(true);
+  if (!wifiEventsInit())
+    return ESP_ERR_NO_MEM;
+
+  wifi_config_t conf;
+  if (esp_wifi_get_config(WIFI_IF_STA, &conf) != ESP_OK ||
+      conf.sta.ssid[0] == 0)
+    return ESP_ERR_NOT_FOUND;
+
+  // Retries are paced against our deadline, not the Arduino reconnect logic
+  WiFi.setAutoReconnect(false);
+
+  // Cached AP and channel, reusing the lease while it is fresh enough
+  if (wifiCache.magic == WIFI_CACHE_MAGIC &&
+      wifiPinAP(wifiCache.bssid, wifiCache.channel)) {
+    wifiPinned = true;
+    wifiLeaseReused =
+        wifiCache.ip != 0 && wifiCache.leaseReuses < WIFI_LEASE_REUSE_MAX;
+    if (wifiLeaseReused)
+      WiFi.config(IPAddress(wifiCache.ip), IPAddress(wifiCache.gateway),
+                  IPAddress(wifiCache.subnet), IPAddress(wifiCache.dns1),
+                  IPAddress(wifiCache.dns2));
+  }
+
+  wifiStartMillis = millis();
+  if (!wifiStartAttempt()) {
+    wifiUnpin();
+    WiFi.setAutoReconnect(true);
+    return ESP_FAIL;
+  }
+
+  wifiStarted = true;
+  return ESP_OK;
+}
+
+// Abandon the association started by WifiBegin() (before WiFiManager runs)
+static void wifiCancel() {
+  if (!wifiStarted)
+    return;
+
+  esp_wifi_disconnect();
+  wifiUnpin();
+  WiFi.setAutoReconnect(true);
+  wifiStarted = false;
+}
+
+// Blocks until the link started by WifiBegin() is up
+esp_err_t WifiWaitReady(unsigned long timeoutMs) {
+  if (!wifiStarted) {
+    esp_err_t err = WifiBegin();
+    if (err == ESP_ERR_NOT_FOUND)
+      Logger::log(Logger::LOG_INFO, "WiFi: no saved credentials.");
+    if (err != ESP_OK)
+      return err;
+  }
+
+  // Time left before the deadline (counted from WifiBegin())
+  auto remaining = [timeoutMs]() -> unsigned long {
+    unsigned long spent = millis() - wifiStartMillis;
+    return spent < timeoutMs ? timeoutMs - spent : 0;
+  };
+
+  // The attempt started by WifiBegin(); the cached AP gets a shorter leash
+  unsigned long first = remaining();
+  if (wifiPinned) {
+    unsigned long spent = millis() - wifiStartMillis;
+    first = spent < WIFI_FAST_CONNECT_TIMEOUT
+                ? min(first, WIFI_FAST_CONNECT_TIMEOUT - spent)
+                : 0;
+  }
+
+  bool connected = wifiAwaitAttempt(first);
+  if (connected && wifiPinned) {
+    Logger::logf(Logger::LOG_INFO,
+                 "WiFi fast connect: channel %u, %s lease, %lu ms",
+                 wifiCache.channel, wifiLeaseReused ? "cached" : "new",
+                 millis() - wifiStartMillis);
+  } else if (wifiPinned) {
+    Logger::log(Logger::LOG_WARNING,
+                "WiFi fast connect failed; falling back to a full scan.");
+    wifiCache.magic = 0;
+  }
+
+  // Full scan + DHCP with whatever time is left
+  if (!connected) {
+    wifiUnpin();
+    for (int attempt = 1; attempt <= 3 && remaining() > 0; attempt++) {
+      Logger::logf(Logger::LOG_DEBUG, "WiFi connection attempt #%d...",
+                   attempt);
+      if (wifiStartAttempt() && wifiAwaitAttempt(remaining())) {
+        connected = true;
+        break;
+      }
+    }
+    if (connected)
+      Logger::logf(Logger::LOG_INFO, "WiFi connected in %lu ms",
+                   millis() - wifiStartMillis);
+  }
+
+  WiFi.setAutoReconnect(true);
+  wifiStarted = false;
+  if (!connected)
+    return ESP_ERR_TIMEOUT;
+
+  wifiCacheStore(wifiLeaseReused);
+  return ESP_OK;
+}
+
 // Draws a QR code on the Inkplate display at the specified coordinates
 static void drawQRCode(Inkplate *display, const String &text, int x, int y,
                        int scale) {
@@ -131,7 +420,24 @@ void configModeCallback(WiFiManager *myWiFiManager) {
 
 // Connects to WiFi or launches the captive portal if connection fails
 esp_err_t WifiConnect(Inkplate &display, int timeoutSeconds, bool forceConfig) {
+  TRACE_ZONE("wifi");
+
+  // Join the saved network directly (picking up an association already
+  // started by WifiBegin()); WiFiManager (and its portal) is only brought up
+  // when that fails or setup is forced
+  if (!forceConfig) {
+    if (WifiWaitReady(WIFI_CONNECT_TIMEOUT) == ESP_OK) {
+      Logger::logf(Logger::LOG_INFO, "WiFi Connected! IP: %s",
+                   WiFi.localIP().toString().c_str());
+      return ESP_OK;
+    }
+    Logger::log(Logger::LOG_WARNING,
+                "WiFi direct connect failed; starting WiFi Manager.");
+  }
+
+  wifiCancel();
   WiFi.mode(WIFI_STA);
+
   _apDisplay = &display;
 
   // Initialize WiFiManager
@@ -150,6 +456,7 @@ esp_err_t WifiConnect(Inkplate &display, int timeoutSeconds, bool forceConfig) {
     Logger::log(Logger::LOG_INFO,
                 "Long press detected: Forcing Config Portal...");
     // Launch AP immediately without trying to connect first
+    wifiCache.magic = 0; // Credentials may change
     res = wm.startConfigPortal("Inky-Renderer");
   } else {
     // Try to connect to saved WiFi first, then launch AP if it fails
@@ -168,31 +475,49 @@ esp_err_t WifiConnect(Inkplate &display, int timeoutSeconds, bool forceConfig) {
 
   Logger::logf(Logger::LOG_INFO, "WiFi Connected! IP: %s",
                WiFi.localIP().toString().c_str());
+  wifiCacheStore(false);
   return ESP_OK;
 }
 
-// Connects to the MQTT broker using the provided configuration
-esp_err_t MqttConnect(const JsonVariant &mqttConfig) {
-  // Validate config type
-  if (!mqttConfig.is<JsonObject>()) {
-    Logger::log(Logger::LOG_ERROR, "Invalid MQTT config; expected JsonObject");
-    return ESP_ERR_INVALID_ARG;
+// Disconnects from the AP and turns the radio off
+esp_err_t WifiShutdown(unsigned long timeoutMs) {
+  esp_err_t err = ESP_OK;
+  if (WiFi.status() == WL_CONNECTED && wifiEventsInit()) {
+    xEventGroupClearBits(wifiEvents, WIFI_LINK_DOWN_BIT);
+    esp_wifi_disconnect();
+    EventBits_t got =
+        xEventGroupWaitBits(wifiEvents, WIFI_LINK_DOWN_BIT, pdFALSE, pdFALSE,
+                            pdMS_TO_TICKS(timeoutMs));
+    if (!(got & WIFI_LINK_DOWN_BIT))
+      err = ESP_ERR_TIMEOUT;
   }
 
-  // Extract MQTT settings with defaults
-  const char *server = mqttConfig["server"] | "";
-  const int port = mqttConfig["port"] | 1883;
-  const char *user = mqttConfig["user"] | "";
-  const char *pass = mqttConfig["pass"] | "";
-  const char *deviceId = mqttConfig["device"] | "inky";
-  int retries = mqttConfig["retries"] | 3;
-  int maxtx = mqttConfig["maxtx"] | MQTT_MAX_PACKET_SIZE;
-  int maxrx = mqttConfig["maxrx"] | MQTT_MAX_PACKET_SIZE;
-  bool useTLS = mqttConfig["tls"] | false;
+  WiFi.mode(WIFI_OFF);
+  Energy::radio(false);
+  return err;
+}
+
+// Connects to the MQTT broker using the provided configuration
+esp_err_t MqttConnect(const AppConfig::Mqtt &mqttConfig) {
+  TRACE_ZONE("mqtt");
+
+  // MQTT settings (defaults applied when the config was loaded)
+  const char *server = mqttConfig.server;
+  const int port = mqttConfig.port;
+  const char *user = mqttConfig.user;
+  const char *pass = mqttConfig.pass;
+  const char *deviceId = mqttConfig.device;
+  int retries = mqttConfig.retries;
+  int maxtx = mqttConfig.maxtx;
+  int maxrx = mqttConfig.maxrx;
+  bool useTLS = mqttConfig.tls;
 
   Logger::logf(Logger::LOG_INFO, "MQTT: %s:%d (TLS=%s)", server, port,
                useTLS ? "true" : "false");
 
+  // Keep the logger off the client while it's being (re)configured
+  Logger::setMQTTConnected(false);
+
   // Configure client based on TLS setting
   if (useTLS) {
     if (!TLSConfigureClient(wifiClientSecure)) {
@@ -205,7 +530,14 @@ esp_err_t MqttConnect(const JsonVariant &mqttConfig) {
     mqttClient.setClient(wifiClient);
   }
 
-  mqttClient.setServer(server, port);
+  // Plain MQTT can connect to the cached address; TLS needs the hostname
+  // for SNI and certificate checks
+  IPAddress serverIP;
+  bool useCachedIP = !useTLS && DNSCache::resolve(server, serverIP);
+  if (useCachedIP)
+    mqttClient.setServer(serverIP, port);
+  else
+    mqttClient.setServer(server, port);
   mqttClient.setBufferSize(maxrx, maxtx);
 
   // Attempt connection loop
@@ -213,78 +545,183 @@ esp_err_t MqttConnect(const JsonVariant &mqttConfig) {
   while (attempts++ < retries && !mqttClient.connected()) {
     Logger::logf(Logger::LOG_DEBUG, "MQTT connection attempt #%d/%d...",
                  attempts, retries);
-    // Connect with or without credentials
-    if (user && strlen(user) > 0) {
-      mqttClient.connect(deviceId, user, pass);
-    } else {
-      mqttClient.connect(deviceId);
+    // Connect with or without credentials (the TLS handshake at full clock)
+    {
+      PowerProfile::Boost boost(useTLS);
+      if (user && strlen(user) > 0) {
+        mqttClient.connect(deviceId, user, pass);
+      } else {
+        mqttClient.connect(deviceId);
+      }
+    }
+
+    // The broker may have moved; look it up again for the next attempt
+    if (!mqttClient.connected() && useCachedIP) {
+      DNSCache::invalidate(server);
+      if (DNSCache::resolve(server, serverIP))
+        mqttClient.setServer(serverIP, port);
     }
     delay(500);
   }
 
-  return mqttClient.connected() ? ESP_OK : ESP_ERR_TIMEOUT;
+  if (!mqttClient.connected())
+    return ESP_ERR_TIMEOUT;
+
+  Logger::setMQTTConnected(true);
+  return ESP_OK;
 }
 
-// Reads data from a WiFi stream into a byte vector, handling chunked transfer
-// encoding
-PsramVector readStream(WiFiClient &stream, unsigned long timeoutMillis,
-                       bool isChunked, size_t contentLength) {
+// Exposes the socket behind a WiFiClientSecure so we can select() on it.
+// WiFiClientSecure doesn't offer it publicly; this reads the protected
+// 'sslclient' member, whose layout belongs to the core. It is only used on
+// the 2.x core it was checked against. Elsewhere there is no descriptor,
+// and readStream() falls back to polling available() a tick at a time.
+struct SecureSocketAccess : public WiFiClientSecure {
+  static int fd(WiFiClientSecure &client) {
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR == 2
+    auto ctx = client.*(&SecureSocketAccess::sslclient);
+    return ctx ? ctx->socket : -1;
+#else
+    (void)client;
+    return -1;
+#endif
+  }
+};
+
+// Blocks until the socket is readable (or closed) or the timeout expires.
+// Without a descriptor we can only yield for a tick and check again.
+static void waitReadable(int fd, unsigned long timeoutMs) {
+  if (fd < 0) {
+    vTaskDelay(1);
+    return;
+  }
+
+  fd_set readfds;
+  FD_ZERO(&readfds);
+  FD_SET(fd, &readfds);
+
+  struct timeval tv;
+  tv.tv_sec = timeoutMs / 1000;
+  tv.tv_usec = (timeoutMs % 1000) * 1000;
+  select(fd + 1, &readfds, nullptr, nullptr, &tv);
+}
+
+// Inflater output for readStreamImpl(), capped at BOARD_MAX_BODY
+struct BoundedBody {
+  PsramVector *out;
+  bool overflow;
+};
+
+// Appends inflated output unless it would pass BOARD_MAX_BODY
+static void appendBounded(void *ctx, const uint8_t *data, size_t len) {
+  BoundedBody *body = static_cast<BoundedBody *>(ctx);
+  if (body->overflow || body->out->size() + len > BOARD_MAX_BODY) {
+    body->overflow = true;
+    return;
+  }
+  body->out->insert(body->out->end(), data, data + len);
+}
+
+// Reads data from a stream into a byte vector, handling chunked transfer
+// encoding. Plain data is read straight into the tail of the output vector;
+// compressed data goes through a scratch span and the inflater. Either way
+// the body fails once it passes BOARD_MAX_BODY (a small compressed body can
+// inflate to anything).
+static PsramVector readStreamImpl(Client &stream, int fd,
+                                  unsigned long timeoutMillis, bool isChunked,
+                                  size_t contentLength, size_t readSize,
+                                  Inflater *inflater, size_t *wireBytes) {
   PsramVector out;
+  PsramVector scratch;
+  BoundedBody bounded = {&out, false};
+  size_t received = 0;
   unsigned long start = millis();
-  unsigned long deadline = start + timeoutMillis;
+  unsigned long lastData = start;
+
+  if (readSize == 0)
+    readSize = READSTREAM_READ_SIZE;
 
   // Reserve memory if size is known to avoid reallocations
-  if (!isChunked && contentLength > 0)
+  if (inflater)
+    scratch.resize(readSize);
+  else if (!isChunked && contentLength > 0)
     out.reserve(contentLength);
 
-  // Buffer for reading data
-  constexpr size_t BUF_SIZE = 256;
-  uint8_t buf[BUF_SIZE];
-
-  // Read loop
-  while (millis() < deadline) {
-    // Check availability
-    if (stream.available() <= 0) {
-      if (!stream.connected())
-        break;
-      delay(5);
-      continue;
+  // Appends up to 'limit' bytes to 'out', waiting for the socket if needed.
+  // Returns the number of bytes read, or -1 on timeout/close/error.
+  auto readSpan = [&](size_t limit) -> int {
+    while (stream.available() <= 0) {
+      unsigned long idle = millis() - lastData;
+      if (idle >= timeoutMillis || !stream.connected())
+        return -1;
+      waitReadable(fd, timeoutMillis - idle);
     }
 
-    // Handle standard (non-chunked) transfer
-    if (!isChunked) {
-      // NDouble-check capacity to ensure no geometric growth occurs during
-      // inserts This prevents the vector from allocating 2x memory if it hits
-      // capacity
-      if (contentLength > 0 && out.capacity() < contentLength)
-        out.reserve(contentLength);
-
-      // Determine how much to read
-      size_t want = (contentLength > 0)
-                        ? min<size_t>({BUF_SIZE, (size_t)stream.available(),
-                                       contentLength - out.size()})
-                        : min<size_t>(BUF_SIZE, (size_t)stream.available());
-
-      // Read data and append to output vector
-      int n = stream.readBytes(buf, want);
+    size_t want = min(limit, readSize);
+
+    // Compressed: inflate the span into the output
+    if (inflater) {
+      int n = stream.read(scratch.data(), want);
+      if (n < 0 || (n > 0 && !inflater->write(scratch.data(), n,
+                                              appendBounded, &bounded)))
+        return -1;
+      if (bounded.overflow) {
+        Logger::logf(Logger::LOG_ERROR, "Inflated body over %u bytes",
+                     (unsigned)BOARD_MAX_BODY);
+        out.clear();
+        return -1;
+      }
       if (n > 0) {
-        out.insert(out.end(), buf, buf + n);
-        // Reset timeout on successful read
-        deadline = millis() + timeoutMillis;
+        received += n;
+        lastData = millis();
       }
+      return n;
+    }
 
-      // Stop if we have read the expected length
-      if (contentLength > 0 && out.size() >= contentLength)
-        break;
+    size_t offset = out.size();
+    if (offset >= BOARD_MAX_BODY) {
+      Logger::logf(Logger::LOG_ERROR, "Body over %u bytes",
+                   (unsigned)BOARD_MAX_BODY);
+      out.clear();
+      return -1;
     }
-    // Handle chunked transfer
-    else {
-      // Buffer for reading the hex-size line
-      constexpr size_t LINE_BUF = 32;
-      char line[LINE_BUF];
+    want = min(want, BOARD_MAX_BODY - offset);
+
+    // Grow geometrically when the final size is unknown
+    if (out.capacity() < offset + want)
+      out.reserve(max(out.capacity() * 2, offset + want));
+
+    out.resize(offset + want);
+    int n = stream.read(out.data() + offset, want);
+    out.resize(offset + (n > 0 ? n : 0));
 
+    if (n < 0)
+      return -1;
+    if (n > 0) {
+      received += n;
+      lastData = millis();
+    }
+    return n;
+  };
+
+  // Handle standard (non-chunked) transfer
+  if (!isChunked) {
+    while (contentLength == 0 || received < contentLength) {
+      size_t limit = contentLength > 0 ? contentLength - received : readSize;
+      if (readSpan(limit) < 0)
+        break;
+    }
+  }
+  // Handle chunked transfer
+  else {
+    // Buffer for reading the hex-size line
+    constexpr size_t LINE_BUF = 32;
+    char line[LINE_BUF];
+    bool failed = false;
+
+    while (!failed) {
       // Read chunk-size line (up to '\n')
-      int len = stream.readBytesUntil('\n', (uint8_t *)line, LINE_BUF - 1);
+      int len = stream.readBytesUntil('\n', line, LINE_BUF - 1);
       if (len <= 0)
         break;
       line[len] = '\0';
@@ -293,59 +730,94 @@ PsramVector readStream(WiFiClient &stream, unsigned long timeoutMillis,
       if (char *cr = strchr(line, '\r'))
         *cr = '\0';
 
-      // Parse hex length from the line
+      // Parse hex length from the line; size 0 indicates end of chunks
       size_t chunkSize = strtoul(line, nullptr, 16);
-      // Size 0 indicates end of chunks
       if (chunkSize == 0)
         break;
 
-      size_t remaining = chunkSize;
       // Read the chunk data
-      while (remaining && millis() < deadline) {
-        // Optimize: Only read if data is available to respect the deadline
-        if (stream.available() <= 0) {
-          delay(10);
-          continue;
-        }
-
-        size_t toRead =
-            min<size_t>({remaining, BUF_SIZE, (size_t)stream.available()});
-        int n = stream.read(buf, toRead);
-
-        if (n <= 0)
+      size_t remaining = chunkSize;
+      while (remaining > 0) {
+        int n = readSpan(remaining);
+        if (n < 0) {
+          failed = true;
           break;
-
-        out.insert(out.end(), buf, buf + n);
+        }
         remaining -= n;
-        deadline = millis() + timeoutMillis;
       }
 
       // Consume the trailing CRLF after the chunk data
-      if (stream.available() >= 2) {
-        char discard[2];
-        stream.readBytes((uint8_t *)discard, 2);
-      } else {
-        stream.readBytesUntil('\n', (uint8_t *)line, LINE_BUF - 1);
-      }
+      if (!failed)
+        stream.readBytesUntil('\n', line, LINE_BUF - 1);
     }
   }
+
+  // A compressed body is only usable if the stream ended cleanly
+  if (inflater && !inflater->finished()) {
+    Logger::log(Logger::LOG_ERROR, "Compressed body truncated or corrupt");
+    out.clear();
+  }
+
+  // Report throughput so read size changes can be compared on devices
+  unsigned long elapsed = millis() - start;
+  Logger::logf(Logger::LOG_DEBUG,
+               "Body: %u bytes (%u on the wire) in %lu ms (%.1f KB/s, span %u)",
+               out.size(), received, elapsed,
+               elapsed > 0 ? received / (1.024 * elapsed) : 0.0, readSize);
+  if (wireBytes)
+    *wireBytes = received;
   return out;
 }
 
-// Fetches a JPEG image from a URL and renders it to the Inkplate
-esp_err_t DisplayImage(Inkplate &display, int rotation, const char *api,
-                       const JsonVariant &imageConfig, const char *endpoint) {
+// Reads data from a WiFi stream into a byte vector
+PsramVector readStream(WiFiClient &stream, unsigned long timeoutMillis,
+                       bool isChunked, size_t contentLength, size_t readSize,
+                       Inflater *inflater, size_t *wireBytes) {
+  return readStreamImpl(stream, stream.fd(), timeoutMillis, isChunked,
+                        contentLength, readSize, inflater, wireBytes);
+}
+
+// Reads data from a TLS stream into a byte vector
+PsramVector readStream(WiFiClientSecure &stream, unsigned long timeoutMillis,
+                       bool isChunked, size_t contentLength, size_t readSize,
+                       Inflater *inflater, size_t *wireBytes) {
+  return readStreamImpl(stream, SecureSocketAccess::fd(stream), timeoutMillis,
+                        isChunked, contentLength, readSize, inflater,
+                        wireBytes);
+}
+
+// Builds the X-Inky-Caps descriptor: board traits plus runtime state
+String DeviceCaps(int rotation, int batteryPercent) {
+  String caps = BOARD_CAPS;
+  caps += ";psram=";
+  caps += ESP.getFreePsram();
+  if (batteryPercent >= 0) {
+    caps += ";batt=";
+    caps += batteryPercent;
+  }
+  caps += ";rot=";
+  caps += rotation;
+  return caps;
+}
+
+// Fetches a JPEG image from the renderer into memory
+esp_err_t FetchImage(int rotation, const char *api,
+                     const AppConfig::Renderer &imageConfig,
+                     const char *endpoint, FetchedImage &image,
+                     int batteryPercent) {
+  TRACE_ZONE("fetch");
+
   // Validate inputs
-  if (!imageConfig.is<JsonObject>())
-    return ESP_ERR_INVALID_ARG;
   if (!api || strlen(api) == 0)
     return ESP_ERR_INVALID_ARG;
 
-  // Parse configuration values
-  const char *basepath = imageConfig["basepath"] | "/api/v1";
+  // Configuration values
+  const char *basepath = imageConfig.basepath;
   bool isPortrait = (rotation % 2 == 0);
-  int retries = imageConfig["retries"] | 3;
-  int timeout = imageConfig["timeout"] | 30;
+  int retries = imageConfig.retries;
+  int timeout = imageConfig.timeout;
+  size_t readSize = imageConfig.readsize;
+  bool compression = imageConfig.compression;
 
   // Construct the full URL
   URLParser::Parser parsed(api);
@@ -359,13 +831,12 @@ esp_err_t DisplayImage(Inkplate &display, int rotation, const char *api,
   Logger::logf(Logger::LOG_DEBUG, "Fetching image: %s",
                parsed.getURL(true).c_str());
 
-  // Buffer for reading data (declared outside scope to persist after network
-  // closes)
-  PsramVector buffer;
-
-  // Variables to hold header data needed for rendering
-  bool noDithering = false;
-  String msg0, msg1, msg2;
+  // Buffer and header data needed for rendering
+  PsramVector &buffer = image.data;
+  bool &noDithering = image.noDithering;
+  String &msg0 = image.messages[0];
+  String &msg1 = image.messages[1];
+  String &msg2 = image.messages[2];
 
   // Enclose network clients so they are destroyed before image
   // processing
@@ -385,6 +856,8 @@ esp_err_t DisplayImage(Inkplate &display, int rotation, const char *api,
     // Setup SimpleHTTP
     SimpleHTTP https;
     https.setUserAgent(USER_AGENT);
+    https.setAcceptEncoding(compression);
+    https.setConnector(DNSCache::connectSecure);
 
     // Retry loop for fetching image
     for (int i = 1; i <= retries; i++) {
@@ -394,7 +867,8 @@ esp_err_t DisplayImage(Inkplate &display, int rotation, const char *api,
       Logger::logf(Logger::LOG_DEBUG, "Attempt %d/%d...", i, retries);
 
       // Start connection
-      if (https.begin(client, parsed.getURL(true))) {
+      String url = parsed.getURL(true);
+      if (https.begin(client, url)) {
         https.setTimeout(timeout * 1000);
 
         // Set Authorization Headers if needed
@@ -402,11 +876,28 @@ esp_err_t DisplayImage(Inkplate &display, int rotation, const char *api,
         if (basicAuth.exists())
           https.addHeader("Authorization", "Basic " + basicAuth.encode());
 
+        // Describe what we can decode so the renderer can pick the payload
+        https.addHeader("X-Inky-Caps", DeviceCaps(rotation, batteryPercent));
+
         // Collect custom headers
         https.collectHeaders(displayHeaders, sizeof(displayHeaders) /
                                                  sizeof(displayHeaders[0]));
 
         int code = https.GET();
+        RedirectCache::observe(api, url, https, code);
+        if (code != HTTP_CODE_OK)
+          NetMetrics::record("image", code, https.getTiming());
+        if (code > 0)
+          readWakeHints(https, image);
+
+        // The server asked us to back off; don't use up the retries on it
+        if (image.retryAfter > 0 && code != HTTP_CODE_OK) {
+          Logger::logf(Logger::LOG_ERROR, "HTTP Error: %d (retry after %us)",
+                       code, image.retryAfter);
+          https.end();
+          break;
+        }
+
         // Check for successful response
         if (code == HTTP_CODE_OK) {
           // Log Source if provided in headers
@@ -434,38 +925,47 @@ esp_err_t DisplayImage(Inkplate &display, int rotation, const char *api,
 
           // Check for sensible size limits to prevent buffer overflow
           // Limit strictly to 2MB to ensure conversion headroom in PSRAM
-          if (len > (2 * 1024 * 1024)) {
+          if (len > BOARD_MAX_BODY) {
             Logger::logf(Logger::LOG_ERROR, "Content too large: %d bytes", len);
             https.end();
             continue;
           }
 
-          // Get the network stream
-          WiFiClient *stream = https.getStreamPtr();
-          if (stream) {
-            // Read data into buffer
-            buffer = readStream(*stream, 1500, isChunked, len);
-
-            // Capture headers before closing the connection
-            if (https.hasHeader("X-No-Dithering") &&
-                https.header("X-No-Dithering") == "true")
-              noDithering = true;
-
-            // Capture headers before closing the connection
-            if (https.hasHeader("X-Inky-Message-0"))
-              msg0 = https.header("X-Inky-Message-0");
-            if (https.hasHeader("X-Inky-Message-1"))
-              msg1 = https.header("X-Inky-Message-1");
-            if (https.hasHeader("X-Inky-Message-2"))
-              msg2 = https.header("X-Inky-Message-2");
-
-            // Close connection
+          // Compressed bodies are inflated while reading
+          Inflater *inflater = https.getInflater();
+          if (https.isEncoded() && !inflater) {
+            Logger::logf(Logger::LOG_ERROR, "Unsupported content encoding: %s",
+                         https.header("Content-Encoding").c_str());
             https.end();
-
-            // If we got data, break the retry loop and proceed to processing
-            if (!buffer.empty())
-              break;
+            continue;
           }
+
+          // Read data into buffer
+          size_t wireBytes = 0;
+          buffer = readStream(client, 1500, isChunked, len > 0 ? len : 0,
+                              readSize, inflater, &wireBytes);
+          https.markBodyComplete(wireBytes);
+          NetMetrics::record("image", code, https.getTiming());
+
+          // Capture headers before closing the connection
+          if (https.hasHeader("X-No-Dithering") &&
+              https.header("X-No-Dithering") == "true")
+            noDithering = true;
+
+          // Capture headers before closing the connection
+          if (https.hasHeader("X-Inky-Message-0"))
+            msg0 = https.header("X-Inky-Message-0");
+          if (https.hasHeader("X-Inky-Message-1"))
+            msg1 = https.header("X-Inky-Message-1");
+          if (https.hasHeader("X-Inky-Message-2"))
+            msg2 = https.header("X-Inky-Message-2");
+
+          // Close connection
+          https.end();
+
+          // If we got data, break the retry loop and proceed to processing
+          if (!buffer.empty())
+            break;
         } else {
           Logger::logf(Logger::LOG_ERROR, "HTTP Error: %d", code);
         }
@@ -475,57 +975,77 @@ esp_err_t DisplayImage(Inkplate &display, int rotation, const char *api,
     }
   } // client and https are destroyed here, freeing SSL buffers
 
+  return buffer.empty() ? ESP_ERR_TIMEOUT : ESP_OK;
+}
+
+// Decodes a fetched image and draws it (plus header messages) to the Inkplate
+esp_err_t RenderImage(Inkplate &display, int rotation, FetchedImage &image) {
+  TRACE_ZONE("decode");
+
+  // Conversion, decode and dithering are all CPU bound
+  PowerProfile::Boost boost;
+
+  PsramVector &buffer = image.data;
+  if (buffer.empty())
+    return ESP_ERR_INVALID_ARG;
+
   // Image Processing & rendering (now running with freed memory)
-  if (!buffer.empty()) {
-    display.clearDisplay();
-
-    // Check if JPEG is compatible (baseline)
-    if (!jpeg_utils::isBaseline(buffer)) {
-      Logger::log(Logger::LOG_INFO,
-                  "Progressive/other JPEG detected. Converting...");
-
-      // std::move transfers ownership so convertToBaseline
-      // can free 'buffer'
-      PsramVector baselineBuffer =
-          jpeg_utils::convertToBaseline(std::move(buffer));
-
-      if (baselineBuffer.empty()) {
-        Logger::log(Logger::LOG_ERROR, "JPEG conversion failed!");
-        return ESP_ERR_INVALID_RESPONSE;
-      }
+  display.clearDisplay();
+
+  // Check if JPEG is compatible (baseline)
+  if (!jpeg_utils::isBaseline(buffer)) {
+    Logger::log(Logger::LOG_INFO,
+                "Progressive/other JPEG detected. Converting...");
 
-      Logger::logf(Logger::LOG_DEBUG, "Converted size: %d bytes",
-                   baselineBuffer.size());
+    // std::move transfers ownership so convertToBaseline
+    // can free 'buffer'
+    PsramVector baselineBuffer =
+        jpeg_utils::convertToBaseline(std::move(buffer));
 
-      // Move the result back into buffer
-      buffer = std::move(baselineBuffer);
+    if (baselineBuffer.empty()) {
+      Logger::log(Logger::LOG_ERROR, "JPEG conversion failed!");
+      return ESP_ERR_INVALID_RESPONSE;
     }
 
-    // Determine dithering setting
-    int dither = static_cast<int>(DITHERING);
-    if (noDithering)
-      dither = 0;
-
-    // Draw the JPEG (buffer is now guaranteed to be baseline if
-    // conversion succeeded)
-    if (display.drawJpegFromBuffer(buffer.data(), buffer.size(), 0, 0, dither,
-                                   0)) {
-      // Display header messages if present
-      if (msg0.length() > 0)
-        Logger::onScreen(Logger::LOG_INFO, false, 0, rotation, msg0.c_str());
-      if (msg1.length() > 0)
-        Logger::onScreen(Logger::LOG_INFO, false, 1, rotation, msg1.c_str());
-      if (msg2.length() > 0)
-        Logger::onScreen(Logger::LOG_INFO, false, 2, rotation, msg2.c_str());
-
-      Logger::log(Logger::LOG_INFO, "Image rendered.");
-      return ESP_OK;
-    } else {
-      Logger::log(Logger::LOG_ERROR, "Render failed");
-    }
+    Logger::logf(Logger::LOG_DEBUG, "Converted size: %d bytes",
+                 baselineBuffer.size());
+
+    // Move the result back into buffer
+    buffer = std::move(baselineBuffer);
+  }
+
+  // Determine dithering setting
+  int dither = static_cast<int>(DITHERING);
+  if (image.noDithering)
+    dither = 0;
+
+  // Draw the JPEG (buffer is now guaranteed to be baseline if
+  // conversion succeeded)
+  if (!display.drawJpegFromBuffer(buffer.data(), buffer.size(), 0, 0, dither,
+                                  0)) {
+    Logger::log(Logger::LOG_ERROR, "Render failed");
+    return ESP_FAIL;
   }
 
-  return ESP_ERR_TIMEOUT;
+  // Display header messages if present
+  for (int pos = 0; pos < 3; pos++)
+    if (image.messages[pos].length() > 0)
+      Logger::onScreen(Logger::LOG_INFO, false, pos, rotation,
+                       image.messages[pos].c_str());
+
+  Logger::log(Logger::LOG_INFO, "Image rendered.");
+  return ESP_OK;
+}
+
+// Fetches a JPEG image from a URL and renders it to the Inkplate
+esp_err_t DisplayImage(Inkplate &display, int rotation, const char *api,
+                       const AppConfig::Renderer &imageConfig,
+                       const char *endpoint) {
+  FetchedImage image;
+  esp_err_t err = FetchImage(rotation, api, imageConfig, endpoint, image);
+  if (err != ESP_OK)
+    return err;
+  return RenderImage(display, rotation, image);
 }
 
 // Starts the OTA web server and blocks execution until timeout or reboot
@@ -576,6 +1096,14 @@ void StartOTAServer(Inkplate &display, int rotation) {
     lastActivity = millis();
   });
 
+  // Wake timeline from the RTC ring, as Chrome trace JSON
+  server.on("/trace.json", HTTP_GET, [&server, &lastActivity]() {
+    StreamString json;
+    Trace::writeJson(json);
+    server.send(200, "application/json", json);
+    lastActivity = millis();
+  });
+
   // Update handler to process file uploads
   server.on(
       "/update", HTTP_POST,
@@ -0,0 +1,59 @@
+#include "power_profile.h"
+#include "energy.h"
+#include "logger.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+namespace PowerProfile {
+// Boosts held; the clock is changed under the lock, so it matches the count
+static SemaphoreHandle_t lock = nullptr;
+static int boosts = 0;
+
+// Switch the CPU clock and tell the energy accounting
+static void setClock(uint32_t mhz) {
+  if (getCpuFrequencyMhz() == mhz)
+    return;
+  if (!setCpuFrequencyMhz(mhz)) {
+    Logger::logf(Logger::LOG_WARNING, "Power: can't set the CPU to %u MHz.",
+                 mhz);
+    return;
+  }
+  Energy::cpuFrequency(mhz);
+}
+
+// Drop to the low clock
+void begin() {
+#if POWER_PROFILE_ENABLED
+  if (!lock)
+    lock = xSemaphoreCreateMutex();
+  if (lock)
+    setClock(POWER_LOW_MHZ);
+#endif
+}
+
+Boost::Boost(bool enable) : _held(false) {
+#if POWER_PROFILE_ENABLED
+  if (!enable || !lock)
+    return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (boosts++ == 0)
+    setClock(POWER_HIGH_MHZ);
+  xSemaphoreGive(lock);
+  _held = true;
+#else
+  (void)enable;
+#endif
+}
+
+Boost::~Boost() {
+#if POWER_PROFILE_ENABLED
+  if (!_held)
+    return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (--boosts == 0)
+    setClock(POWER_LOW_MHZ);
+  xSemaphoreGive(lock);
+#endif
+}
+} // namespace PowerProfile
@@ -0,0 +1,127 @@
+#include "prefetch.h"
+
+#define FS_NO_GLOBALS
+#include <FS.h>
+#ifdef FILE_READ
+#undef FILE_READ
+#endif
+#ifdef FILE_WRITE
+#undef FILE_WRITE
+#endif
+
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <time.h>
+
+#include "logger.h"
+
+namespace Prefetch {
+// Load the stored image for 'endpoint'
+bool load(const char *endpoint, uint32_t maxAgeSeconds, FetchedImage &image) {
+  if (!endpoint || !LittleFS.exists(PREFETCH_META_PATH))
+    return false;
+
+  JsonDocument meta;
+  fs::File metaFile = LittleFS.open(PREFETCH_META_PATH, "r");
+  DeserializationError error = deserializeJson(meta, metaFile);
+  metaFile.close();
+
+  // Only one wake gets to use a prefetched image
+  bool usable = !error;
+  const char *storedEndpoint = meta["endpoint"] | "";
+  uint32_t fetched = meta["fetched"] | 0;
+  uint32_t now = time(NULL);
+  size_t size = meta["size"] | 0;
+  if (usable && strcmp(storedEndpoint, endpoint) != 0) {
+    Logger::logf(Logger::LOG_INFO, "Prefetched image is for %s, not %s.",
+                 storedEndpoint, endpoint);
+    usable = false;
+  } else if (usable && (now < fetched || now - fetched > maxAgeSeconds)) {
+    Logger::logf(Logger::LOG_INFO, "Prefetched image is stale (%u s old).",
+                 now - fetched);
+    usable = false;
+  }
+
+  if (usable) {
+    fs::File file = LittleFS.open(PREFETCH_IMAGE_PATH, "r");
+    if (file && file.size() == size && size > 0) {
+      image.data.resize(size);
+      usable = file.read(image.data.data(), size) == size;
+    } else {
+      usable = false;
+    }
+    if (file)
+      file.close();
+  }
+
+  if (usable) {
+    image.noDithering = meta["nodither"] | false;
+    for (int i = 0; i < 3; i++)
+      image.messages[i] = meta["messages"][i] | "";
+    Logger::logf(Logger::LOG_INFO, "Using prefetched image: %s (%u bytes)",
+                 endpoint, size);
+  } else {
+    image.data.clear();
+  }
+
+  clear();
+  return usable;
+}
+
+// Store an image for 'endpoint'
+bool store(const char *endpoint, const FetchedImage &image) {
+  clear();
+  if (!endpoint || image.data.empty())
+    return false;
+
+  // Make sure the image fits without starving the rest of the filesystem
+  size_t freeBytes = LittleFS.totalBytes() - LittleFS.usedBytes();
+  if (image.data.size() + PREFETCH_FS_RESERVE > freeBytes) {
+    Logger::logf(Logger::LOG_WARNING,
+                 "Prefetch skipped: %u bytes won't fit (%u free).",
+                 image.data.size(), freeBytes);
+    return false;
+  }
+
+  fs::File file = LittleFS.open(PREFETCH_IMAGE_PATH, "w");
+  if (!file)
+    return false;
+  size_t written = file.write(image.data.data(), image.data.size());
+  file.close();
+  if (written != image.data.size()) {
+    Logger::log(Logger::LOG_ERROR, "Prefetch write failed.");
+    clear();
+    return false;
+  }
+
+  // Written last, so a torn write never looks like a valid image
+  JsonDocument meta;
+  meta["endpoint"] = endpoint;
+  meta["fetched"] = (uint32_t)time(NULL);
+  meta["size"] = image.data.size();
+  meta["nodither"] = image.noDithering;
+  for (int i = 0; i < 3; i++)
+    meta["messages"][i] = image.messages[i];
+
+  fs::File metaFile = LittleFS.open(PREFETCH_META_PATH, "w");
+  if (!metaFile || serializeJson(meta, metaFile) == 0) {
+    if (metaFile)
+      metaFile.close();
+    clear();
+    return false;
+  }
+  metaFile.close();
+
+  Logger::logf(Logger::LOG_INFO, "Prefetched %s (%u bytes).", endpoint,
+               image.data.size());
+  return true;
+}
+
+// Remove any stored image
+void clear() {
+  if (LittleFS.exists(PREFETCH_META_PATH))
+    LittleFS.remove(PREFETCH_META_PATH);
+  if (LittleFS.exists(PREFETCH_IMAGE_PATH))
+    LittleFS.remove(PREFETCH_IMAGE_PATH);
+}
+} // namespace Prefetch
@@ -0,0 +1,86 @@
+#include "redirect_cache.h"
+#include "logger.h"
+
+#include <esp_attr.h>
+#include <freertos/FreeRTOS.h>
+#include <time.h>
+
+namespace RedirectCache {
+// The configured base and where it was last permanently redirected to
+struct Entry {
+  char from[REDIRECT_CACHE_URL_LEN];
+  char to[REDIRECT_CACHE_URL_LEN];
+  uint32_t learnedAt; // time(NULL) when the redirect was seen
+};
+
+RTC_DATA_ATTR static Entry entry;
+
+// Copy of the target handed out by apply(); observe() runs on the network
+// workers and may rewrite the entry while requests still use the old base
+static char active[REDIRECT_CACHE_URL_LEN];
+static const char *configured = nullptr;
+static portMUX_TYPE cacheMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Whether the entry is for 'api' and still within its lifetime
+static bool live(const char *api) {
+  uint32_t now = time(NULL);
+  return entry.from[0] && entry.to[0] && strcmp(entry.from, api) == 0 &&
+         now >= entry.learnedAt && now - entry.learnedAt < REDIRECT_CACHE_TTL;
+}
+
+// The base URL to use for 'api'
+const char *apply(const char *api) {
+  configured = api;
+  if (!api || !live(api))
+    return api;
+
+  strncpy(active, entry.to, sizeof(active) - 1);
+  active[sizeof(active) - 1] = '\0';
+  Logger::logf(Logger::LOG_DEBUG, "API base redirected: %s", active);
+  return active;
+}
+
+// Inspect a finished request made against 'base'
+void observe(const char *base, const String &url, SimpleHTTP &http,
+             int code) {
+  if (!configured || !base)
+    return;
+
+  // The cached target stopped answering; go back to the configured base
+  if (base == active && (code < 0 || code == 404)) {
+    portENTER_CRITICAL(&cacheMux);
+    entry.from[0] = '\0';
+    portEXIT_CRITICAL(&cacheMux);
+    Logger::log(Logger::LOG_WARNING, "Cached API redirect dropped.");
+    return;
+  }
+
+  const String &target = http.getPermanentURL();
+  size_t baseLen = strlen(base);
+  if (target.isEmpty() || !url.startsWith(base))
+    return;
+
+  // Only a move of the whole base can be replayed for other endpoints
+  String below = url.substring(baseLen);
+  if (!target.endsWith(below)) {
+    Logger::logf(Logger::LOG_DEBUG, "Redirect to %s not cached (path changed).",
+                 target.c_str());
+    return;
+  }
+
+  // Bases with credentials are skipped; the Location won't carry them
+  String to = target.substring(0, target.length() - below.length());
+  if (strlen(configured) >= REDIRECT_CACHE_URL_LEN ||
+      to.length() >= REDIRECT_CACHE_URL_LEN || strchr(configured, '@'))
+    return;
+
+  portENTER_CRITICAL(&cacheMux);
+  strcpy(entry.from, configured);
+  strcpy(entry.to, to.c_str());
+  entry.learnedAt = time(NULL);
+  portEXIT_CRITICAL(&cacheMux);
+
+  Logger::logf(Logger::LOG_INFO, "API base moved permanently: %s -> %s",
+               configured, to.c_str());
+}
+} // namespace RedirectCache
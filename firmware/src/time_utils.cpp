@@ -1,15 +1,21 @@
 #include <ArduinoJson.h>
 #include <Inkplate.h>
 #include <esp_err.h>
+#include <esp_sntp.h>
 #include <map>
 
+#include "clock_drift.h"
 #include "definitions.h"
+#include "dns_cache.h"
 #include "logger.h"
+#include "net_metrics.h"
+#include "redirect_cache.h"
 #include "simplehttp.h"
 #include "sys/time.h"
 #include "time.h"
 #include "time_utils.h"
 #include "tls_utils.h"
+#include "trace.h"
 #include "urlparser.h"
 
 // Function to get the local time as a string (e.g., "2025-01-01 12:00:00 AM")
@@ -219,7 +225,8 @@ time_t getNextIntervalTime(time_t now, const String &intervalStr) {
 
 // Retrieves the epoch time of the earliest scheduled wake that is strictlyafter
 // 'now'. Returns (time_t)(-1) if none found
-WakeEntry getNextScheduledWake(time_t now, const JsonObject &wakes) {
+WakeEntry getNextScheduledWake(time_t now, const WakeSlot *wakes,
+                               size_t wakeCount) {
   // Initialize "best" as an invalid entry:
   //   - epoch = -1 indicates "no valid schedule found"
   //   - endpoint = "" is empty
@@ -231,11 +238,10 @@ WakeEntry getNextScheduledWake(time_t now, const JsonObject &wakes) {
   struct tm currentTm;
   localtime_r(&now, &currentTm);
 
-  // Iterate the JsonObject directly
-  for (JsonPair kv : wakes) {
+  for (size_t i = 0; i < wakeCount; i++) {
     // Key is the time (e.g., "10:30am"), Value is the endpoint
-    String timeStr = kv.key().c_str();
-    String endpointStr = kv.value().as<const char *>();
+    String timeStr = wakes[i].time;
+    String endpointStr = wakes[i].endpoint;
 
     ParsedTime pt = parseTime(timeStr);
     if (!pt.valid)
@@ -263,74 +269,186 @@ WakeEntry getNextScheduledWake(time_t now, const JsonObject &wakes) {
   return best;
 }
 
-// Calculates the next wake time based on the sleep window and wake schedule
-WakeEntry calculateNextWake(
-    time_t currentEpoch,
-    const String &sleepStartStr, // e.g. "11:30pm" or 22:30"
-    const String &sleepStopStr,  // e.g. "7:30am" or "07:30"
-    const JsonObject &wakes, const String &defaultEndpoint,
-    const String &intervalStr // e.g. "1h30m", "45m", "2h15m30s", etc
-) {
-  bool hasSleepWindow = true;
-
-  // If either sleep string is empty, we have no window
-  if (sleepStartStr.isEmpty() || sleepStopStr.isEmpty())
-    hasSleepWindow = false;
-
-  ParsedTime sleepStart, sleepStop;
-  if (hasSleepWindow) {
-    sleepStart = parseTime(sleepStartStr);
-    sleepStop = parseTime(sleepStopStr);
-
-    // If either parse fails, skip the sleep window logic
-    if (!sleepStart.valid || !sleepStop.valid)
-      hasSleepWindow = false;
+// Wake schedule compiled from the config: the sleep window and interval
+// parsed, and the wakes sorted by time of day. Kept in RTC memory and only
+// rebuilt when the schedule's hash changes, so a wake finds its next alarm
+// with a binary search instead of parsing every entry.
+struct WakeTable {
+  uint32_t hash;
+  int16_t sleepStart; // Minutes since midnight (-1 if no sleep window)
+  int16_t sleepStop;
+  int32_t interval;   // Seconds (<= 0: top of the hour)
+  uint16_t count;     // Wakes in the table (WAKE_TABLE_OVERFLOW if too many)
+  uint16_t minutes[WAKE_TABLE_MAX]; // Sorted minutes since midnight
+  uint16_t keys[WAKE_TABLE_MAX];    // Index of each entry in 'wakes'
+};
+
+#define WAKE_TABLE_OVERFLOW 0xFFFF
+
+RTC_DATA_ATTR static WakeTable wakeTable;
+
+// 32-bit FNV-1a over a string, including its terminator
+static uint32_t hashString(uint32_t hash, const char *s) {
+  if (s)
+    for (; *s; s++)
+      hash = (hash ^ (uint8_t)*s) * 16777619u;
+  return (hash ^ 0xFF) * 16777619u;
+}
+
+// The compiled schedule, rebuilt if the inputs changed since the last wake
+static const WakeTable &compileWakes(const String &sleepStartStr,
+                                     const String &sleepStopStr,
+                                     const WakeSlot *wakes, size_t wakeCount,
+                                     const String &intervalStr) {
+  uint32_t hash = 2166136261u;
+  hash = hashString(hash, sleepStartStr.c_str());
+  hash = hashString(hash, sleepStopStr.c_str());
+  hash = hashString(hash, intervalStr.c_str());
+  for (size_t i = 0; i < wakeCount; i++) {
+    hash = hashString(hash, wakes[i].time);
+    hash = hashString(hash, wakes[i].endpoint);
   }
+  hash = hash ? hash : 1; // 0 marks an empty table
+
+  if (wakeTable.hash == hash)
+    return wakeTable;
+
+  WakeTable &t = wakeTable;
+  t.hash = 0;
+
+  ParsedTime start = parseTime(sleepStartStr);
+  ParsedTime stop = parseTime(sleepStopStr);
+  bool hasWindow = !sleepStartStr.isEmpty() && !sleepStopStr.isEmpty() &&
+                   start.valid && stop.valid;
+  t.sleepStart = hasWindow ? start.hour * 60 + start.minute : -1;
+  t.sleepStop = hasWindow ? stop.hour * 60 + stop.minute : -1;
+  t.interval = parseDuration(intervalStr);
+
+  // Insertion sort keeps entries with the same time in config order, so the
+  // first one still wins
+  t.count = 0;
+  for (size_t position = 0; position < wakeCount; position++) {
+    ParsedTime pt = parseTime(wakes[position].time);
+    if (pt.valid) {
+      if (t.count == WAKE_TABLE_MAX) {
+        Logger::logf(Logger::LOG_WARNING,
+                     "More than %d wakes; scheduling from the config.",
+                     WAKE_TABLE_MAX);
+        t.count = WAKE_TABLE_OVERFLOW;
+        break;
+      }
 
-  // If no sleep window, just pick the next scheduled wake or the next interval
-  if (!hasSleepWindow) {
-    // Simply pick the earlier of the next scheduled wake or next interval
-    // boundary
-    time_t nextInterval = getNextIntervalTime(currentEpoch, intervalStr);
-    WakeEntry scheduledWake = getNextScheduledWake(currentEpoch, wakes);
-
-    // If there is a scheduled wake, use it
-    if (scheduledWake.epoch != (time_t)(-1) &&
-        scheduledWake.epoch <= nextInterval) {
-      return scheduledWake;
-    } else {
-      return WakeEntry{nextInterval, defaultEndpoint, ""};
+      uint16_t minute = pt.hour * 60 + pt.minute;
+      int i = t.count++;
+      for (; i > 0 && t.minutes[i - 1] > minute; i--) {
+        t.minutes[i] = t.minutes[i - 1];
+        t.keys[i] = t.keys[i - 1];
+      }
+      t.minutes[i] = minute;
+      t.keys[i] = position;
     }
   }
 
-  // Otherwise, we have a sleep window, so calculate the next wake
-  WakeEntry result;
+  t.hash = hash;
+  if (t.count != WAKE_TABLE_OVERFLOW)
+    Logger::logf(Logger::LOG_DEBUG, "Wake schedule compiled: %d wakes.",
+                 t.count);
+  return t;
+}
 
-  // Convert sleep boundaries to minutes since midnight
-  int startMinutes = sleepStart.hour * 60 + sleepStart.minute;
-  int stopMinutes = sleepStop.hour * 60 + sleepStop.minute;
-  bool crossesMidnight = (startMinutes > stopMinutes);
+// Next scheduled wake from the table: a binary search for the first wake
+// after the current minute, then a single mktime()
+static WakeEntry nextScheduledWake(time_t now, const WakeTable &table,
+                                   const WakeSlot *wakes, size_t wakeCount) {
+  if (table.count == WAKE_TABLE_OVERFLOW)
+    return getNextScheduledWake(now, wakes, wakeCount);
 
-  // Convert current time to local time
-  struct tm currentTm;
-  localtime_r(&currentEpoch, &currentTm);
-  int currentMinutes = currentTm.tm_hour * 60 + currentTm.tm_min;
+  WakeEntry best;
+  best.epoch = (time_t)(-1);
+  if (table.count == 0)
+    return best;
+
+  struct tm tm;
+  localtime_r(&now, &tm);
+  uint16_t minute = tm.tm_hour * 60 + tm.tm_min;
+
+  // Wakes at the current minute have already passed (they fire at :00)
+  int lo = 0, hi = table.count;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (table.minutes[mid] <= minute)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  bool tomorrow = lo == table.count;
+  int slot = tomorrow ? 0 : lo;
+
+  tm.tm_hour = table.minutes[slot] / 60;
+  tm.tm_min = table.minutes[slot] % 60;
+  tm.tm_sec = 0;
+  best.epoch = mktime(&tm) + (tomorrow ? 24 * 3600 : 0);
+
+  const WakeSlot &wake = wakes[table.keys[slot]];
+  best.time = wake.time;
+  best.endpoint = wake.endpoint;
+  return best;
+}
+
+// Next interval wake (the top of the hour if no interval is set), no
+// sooner than 'minInterval' from now
+static time_t nextIntervalTime(time_t now, const WakeTable &table,
+                               uint32_t minInterval) {
+  time_t next =
+      table.interval > 0 ? now + table.interval : getNextIntervalTime(now);
+  if (next < now + (time_t)minInterval)
+    next = now + minInterval;
+  return next;
+}
+
+// Whether 'minutes' since midnight falls in the table's sleep window
+static bool inSleepWindow(int minutes, const WakeTable &table) {
+  if (table.sleepStart < 0)
+    return false;
+  if (table.sleepStart <= table.sleepStop)
+    return minutes >= table.sleepStart && minutes < table.sleepStop;
+  return minutes >= table.sleepStart || minutes < table.sleepStop;
+}
+
+// Whether 'epoch' falls in the table's sleep window
+static bool inSleepWindow(time_t epoch, const WakeTable &table) {
+  struct tm tm;
+  localtime_r(&epoch, &tm);
+  return inSleepWindow(tm.tm_hour * 60 + tm.tm_min, table);
+}
+
+// Calculates the next wake time based on the sleep window and wake schedule
+static WakeEntry nextWake(time_t currentEpoch, const WakeTable &table,
+                          const WakeSlot *wakes, size_t wakeCount,
+                          const String &sleepStopStr, // e.g. "7:30am"
+                          const String &defaultEndpoint,
+                          uint32_t minInterval = 0) {
+  // Pick the earlier of the next scheduled wake or next interval boundary
+  time_t nextInterval = nextIntervalTime(currentEpoch, table, minInterval);
+  WakeEntry scheduledWake =
+      nextScheduledWake(currentEpoch, table, wakes, wakeCount);
+  WakeEntry candidate{nextInterval, defaultEndpoint, ""};
+  if (scheduledWake.epoch != (time_t)(-1) &&
+      scheduledWake.epoch <= nextInterval)
+    candidate = scheduledWake;
+
+  // If no sleep window, that's it
+  if (table.sleepStart < 0)
+    return candidate;
 
   // If we are already in the sleep window, schedule wake-up at sleepStop
-  bool currentlySleeping = false;
-  if (!crossesMidnight) {
-    currentlySleeping =
-        (currentMinutes >= startMinutes && currentMinutes < stopMinutes);
-  } else {
-    // For windows crossing midnight (e.g. 10:30pm to 7:30am)
-    currentlySleeping =
-        (currentMinutes >= startMinutes || currentMinutes < stopMinutes);
-  }
-  if (currentlySleeping) {
+  struct tm currentTm;
+  localtime_r(&currentEpoch, &currentTm);
+  if (inSleepWindow(currentTm.tm_hour * 60 + currentTm.tm_min, table)) {
     // Build a time structure for today's sleepStop
     struct tm wakeTm = currentTm;
-    wakeTm.tm_hour = sleepStop.hour;
-    wakeTm.tm_min = sleepStop.minute;
+    wakeTm.tm_hour = table.sleepStop / 60;
+    wakeTm.tm_min = table.sleepStop % 60;
     wakeTm.tm_sec = 0;
     time_t sleepStopEpoch = mktime(&wakeTm);
 
@@ -340,160 +458,283 @@ WakeEntry calculateNextWake(
       wakeTm.tm_mday += 1;
       sleepStopEpoch = mktime(&wakeTm);
     }
-    result.epoch = sleepStopEpoch;
-    result.endpoint = defaultEndpoint;
-    result.time = sleepStopStr;
-    return result;
-  }
-
-  // Not currently sleeping; choose between the next scheduled wake and next
-  // top-of-hour
-  time_t nextInterval = getNextIntervalTime(currentEpoch, intervalStr);
-  WakeEntry scheduledWake = getNextScheduledWake(currentEpoch, wakes);
-  time_t candidateEpoch;
-  String candidateEndpoint;
-  String candidateTime;
-  if (scheduledWake.epoch == (time_t)(-1)) {
-    candidateEpoch = nextInterval;
-    candidateEndpoint = defaultEndpoint;
-  } else {
-    // Pick the earlier wake time
-    if (scheduledWake.epoch <= nextInterval) {
-      candidateEpoch = scheduledWake.epoch;
-      candidateEndpoint = scheduledWake.endpoint;
-      candidateTime = scheduledWake.time;
-    } else {
-      candidateEpoch = nextInterval;
-      candidateEndpoint = defaultEndpoint;
-    }
+    return WakeEntry{sleepStopEpoch, defaultEndpoint, sleepStopStr};
   }
 
   // Now check if the candidate falls within the sleep window
   struct tm candidateTm;
-  localtime_r(&candidateEpoch, &candidateTm);
-  int candidateMinutes = candidateTm.tm_hour * 60 + candidateTm.tm_min;
-
-  bool candidateInSleepWindow = false;
-  if (!crossesMidnight) {
-    candidateInSleepWindow =
-        (candidateMinutes >= startMinutes && candidateMinutes < stopMinutes);
-  } else {
-    candidateInSleepWindow =
-        (candidateMinutes >= startMinutes || candidateMinutes < stopMinutes);
-  }
-
-  if (candidateInSleepWindow) {
+  localtime_r(&candidate.epoch, &candidateTm);
+  if (inSleepWindow(candidateTm.tm_hour * 60 + candidateTm.tm_min, table)) {
     // Adjust candidate to the sleepStop time
-    candidateTm.tm_hour = sleepStop.hour;
-    candidateTm.tm_min = sleepStop.minute;
+    candidateTm.tm_hour = table.sleepStop / 60;
+    candidateTm.tm_min = table.sleepStop % 60;
     candidateTm.tm_sec = 0;
     time_t adjustedEpoch = mktime(&candidateTm);
-    if (adjustedEpoch <= candidateEpoch) {
+    if (adjustedEpoch <= candidate.epoch) {
       // If the sleepStop for the candidate day has already passed, add 1 day
       candidateTm.tm_mday += 1;
       adjustedEpoch = mktime(&candidateTm);
     }
-    candidateEpoch = adjustedEpoch;
-    candidateEndpoint = defaultEndpoint;
+    candidate.epoch = adjustedEpoch;
+    candidate.endpoint = defaultEndpoint;
   }
 
-  result.epoch = candidateEpoch;
-  result.endpoint = candidateEndpoint;
-  result.time = candidateTime;
-  return result;
+  return candidate;
 }
 
-// NTP sync function with timezone and retries
-esp_err_t NTPSync(Inkplate &display, const char *api,
-                  const JsonVariant &ntpConfig) {
-  if (!ntpConfig.is<JsonObject>()) {
-    Logger::logf(Logger::LOG_ERROR, "Invalid NTP config; expected JsonObject");
-    return ESP_ERR_INVALID_ARG;
+// Calculates the next wake time, adjusted by the server's hints
+WakeEntry calculateNextWake(time_t currentEpoch, const String &sleepStartStr,
+                            const String &sleepStopStr, const WakeSlot *wakes,
+                            size_t wakeCount, const String &defaultEndpoint,
+                            const String &intervalStr,
+                            const WakeHints *hints) {
+  const WakeTable &table = compileWakes(sleepStartStr, sleepStopStr, wakes,
+                                        wakeCount, intervalStr);
+  if (!hints)
+    return nextWake(currentEpoch, table, wakes, wakeCount, sleepStopStr,
+                    defaultEndpoint);
+
+  // Nothing before Retry-After
+  time_t from = currentEpoch;
+  if (hints->notBefore > from)
+    from = hints->notBefore - 1;
+  WakeEntry wake = nextWake(from, table, wakes, wakeCount, sleepStopStr,
+                            defaultEndpoint, hints->minInterval);
+
+  // Skip wakes that would only fetch the same, still fresh, content
+  for (int i = 0; i < WAKE_HINT_MAX_SKIPS && wake.epoch < hints->freshUntil &&
+                  wake.endpoint == hints->endpoint;
+       i++)
+    wake = nextWake(wake.epoch, table, wakes, wakeCount, sleepStopStr,
+                    defaultEndpoint, hints->minInterval);
+
+  // Come back early for content the server says changes sooner, unless
+  // that falls in the sleep window. Never sooner than the floor or the
+  // battery budget allows, so a bad header can't make the device spin.
+  if (hints->wakeBy) {
+    time_t wakeBy =
+        max<time_t>(hints->wakeBy,
+                    currentEpoch + max<uint32_t>(hints->minInterval,
+                                                 WAKE_HINT_MIN_SECONDS));
+    if (wakeBy < wake.epoch && wakeBy >= hints->notBefore &&
+        !inSleepWindow(wakeBy, table))
+      wake = WakeEntry{wakeBy, hints->endpoint, hints->time};
   }
 
-  JsonObject ntpSettings = ntpConfig.as<JsonObject>();
-  const char *server1 = ntpSettings["server1"] | "time.cloudflare.com";
-  const char *server2 = ntpSettings["server2"] | "pool.ntp.org";
-  const char *timezone = ntpSettings["timezone"] | "America/Los_Angeles";
-  const char *basepath = ntpSettings["basepath"] | "/api/v0/timezone";
-  int retries = ntpSettings["retries"].as<int>() | 3;
-
-  // User-specified offsets (in seconds)
-  int gmtOffset = ntpSettings["gmtoffset"].as<int>() | 0;
-  int daylightOffset = ntpSettings["daylightoffset"].as<int>() | 0;
-
-  // Optionally update offsets from a timezone database API
-  if (timezone[0]) {
-    URLParser::Parser parsed(api);
-    parsed.expandPath(basepath, "timezone",
-                      URLParser::urlEncode(timezone).c_str());
-    Logger::logf(Logger::LOG_DEBUG, "Timezone request: %s",
-                 parsed.getURL(true).c_str());
-
-    WiFiClientSecure client;
-    client.setNoDelay(true);
-    client.setTimeout(5000);
-
-    // Configure TLS
-    if (!TLSConfigureClient(client)) {
-      Logger::log(Logger::LOG_ERROR,
-                  "Skipping timezone API fetch: TLS CA bundle unavailable.");
-      timezone = "";
+  return wake;
+}
+
+// Formats a TZ offset the way configTime() does ("UTC-2", "UTC5:30:00")
+static String formatOffset(const char *name, long offset) {
+  char out[24];
+  if (offset % 3600)
+    snprintf(out, sizeof(out), "%s%ld:%02u:%02u", name, offset / 3600,
+             (unsigned)abs((offset % 3600) / 60), (unsigned)abs(offset % 60));
+  else
+    snprintf(out, sizeof(out), "%s%ld", name, offset / 3600);
+  return out;
+}
+
+// The TZ rule configTime() builds from fixed offsets
+static String offsetRule(long gmtOffset, int daylightOffset) {
+  String rule = formatOffset("UTC", -gmtOffset);
+  rule += daylightOffset != 3600
+              ? formatOffset("DST", -gmtOffset - daylightOffset)
+              : String("DST");
+  return rule;
+}
+
+// Whether a rule from the API looks like a POSIX TZ string: a zone name
+// first, printable, and short enough to keep
+static bool validRule(const char *rule) {
+  size_t len = strlen(rule);
+  if (len < 4 || len >= 64 || !(isalpha(rule[0]) || rule[0] == '<'))
+    return false;
+  for (size_t i = 0; i < len; i++)
+    if (!isprint(rule[i]) || isspace(rule[i]))
+      return false;
+  return true;
+}
+
+// Looks up the POSIX TZ rule for a timezone on the API. Servers that only
+// send the current GMT offset get a fixed rule, with 'cacheable' false since
+// it goes stale at the next DST change. Returns "" on failure.
+static String fetchTimezoneRule(const char *api, const char *basepath,
+                                const char *timezone, bool &cacheable) {
+  cacheable = false;
+
+  URLParser::Parser parsed(api);
+  parsed.expandPath(basepath, "timezone",
+                    URLParser::urlEncode(timezone).c_str());
+  Logger::logf(Logger::LOG_DEBUG, "Timezone request: %s",
+               parsed.getURL(true).c_str());
+
+  WiFiClientSecure client;
+  client.setNoDelay(true);
+  client.setTimeout(5000);
+
+  // Configure TLS
+  if (!TLSConfigureClient(client)) {
+    Logger::log(Logger::LOG_ERROR,
+                "Skipping timezone API fetch: TLS CA bundle unavailable.");
+    return "";
+  }
+
+  // Setup SimpleHTTP
+  SimpleHTTP https;
+  https.setUserAgent(USER_AGENT);
+  https.setAcceptEncoding(true);
+  https.setConnector(DNSCache::connectSecure);
+
+  String rule, url = parsed.getURL(true);
+  if (https.begin(client, url)) {
+    int code = https.GET();
+    RedirectCache::observe(api, url, https, code);
+    NetMetrics::record("timezone", code, https.getTiming());
+    if (code == HTTP_CODE_OK) {
+      JsonDocument tzdata;
+      deserializeJson(tzdata, https.getString());
+      const char *posix = tzdata["posix"] | "";
+      if (validRule(posix)) {
+        rule = posix;
+        cacheable = true;
+      } else if (tzdata["gmtOffset"].is<int>()) {
+        // API returns the GMT offset already adjusted for DST
+        rule = offsetRule(tzdata["gmtOffset"].as<int>(), 0);
+      }
+    } else {
+      Logger::logf(Logger::LOG_ERROR, "Failed to get timezone data: %d",
+                   code);
     }
+    https.end();
+  }
+  return rule;
+}
 
-    // If timezone is't set, use GMT offsets
-    if (!timezone[0]) {
-      Logger::log(
-          Logger::LOG_WARNING,
-          "Using configured GMT/daylight offsets; timezone API disabled.");
+// Resolves the timezone and waits for SNTP, with retries
+esp_err_t NTPFetch(const char *api, const AppConfig::Ntp &ntpConfig) {
+  TRACE_ZONE("ntp");
+
+  const char *server1 = ntpConfig.server1;
+  const char *server2 = ntpConfig.server2;
+  const char *timezone = ntpConfig.timezone;
+  const char *basepath = ntpConfig.basepath;
+  int retries = ntpConfig.retries;
+
+  // The timezone as a POSIX TZ rule, so DST changes are worked out locally:
+  // a rule from the config, the one looked up for the timezone earlier, or
+  // a fresh lookup. The configured offsets stand in when there's none.
+  String rule = ntpConfig.posix;
+  const char *zone = "";
+  time_t now = time(nullptr);
+  bool remember = true;
+  if (!rule.length() && timezone[0]) {
+    const char *cached =
+        ClockDrift::timezoneRule(timezone, now, CLOCK_TZ_RULE_TTL);
+    if (cached) {
+      rule = cached;
+      remember = false; // Already remembered, with the lookup's date
     } else {
-      // Setup SimpleHTTP
-      SimpleHTTP https;
-      https.setUserAgent(USER_AGENT);
-
-      if (https.begin(client, parsed.getURL(true))) {
-        int code = https.GET();
-        if (code == HTTP_CODE_OK) {
-          JsonDocument tzdata;
-          deserializeJson(tzdata, https.getString());
-          gmtOffset = tzdata["gmtOffset"].as<int>();
-          daylightOffset =
-              0; // API returns the GMT offset already adjusted for DST
-        } else {
-          Logger::logf(Logger::LOG_ERROR, "Failed to get timezone data: %d",
-                       code);
-        }
-        https.end();
+      bool cacheable;
+      rule = fetchTimezoneRule(api, basepath, timezone, cacheable);
+      if (cacheable)
+        zone = timezone;
+      if (!rule.length()) {
+        // An expired rule is still better than fixed offsets; keep its date
+        // so the next sync tries the lookup again
+        cached = ClockDrift::timezoneRule(timezone, now, UINT32_MAX);
+        if (cached)
+          rule = cached;
+        remember = false;
       }
     }
   }
+  if (!rule.length()) {
+    if (timezone[0])
+      Logger::log(Logger::LOG_WARNING,
+                  "Using configured GMT/daylight offsets; timezone API "
+                  "unavailable.");
+    rule = offsetRule(ntpConfig.gmtOffset, ntpConfig.daylightOffset);
+  }
 
   Logger::logf(Logger::LOG_INFO,
-               "NTP Servers: %s, %s / Timezone: %s (GMT Offset: %d sec, "
-               "Daylight Offset: %d sec) / Retries: %d",
-               server1, server2, timezone, gmtOffset, daylightOffset, retries);
-  configTime(gmtOffset, daylightOffset, server1, server2);
+               "NTP Servers: %s, %s / Timezone: %s (%s) / Retries: %d",
+               server1, server2, timezone, rule.c_str(), retries);
+  // SNTP keeps pointers to the server names, so the resolved addresses live
+  // in static buffers
+  static char server1IP[16], server2IP[16];
+  const char *host1 = server1, *host2 = server2;
+  IPAddress ip;
+  if (DNSCache::resolve(host1, ip)) {
+    strlcpy(server1IP, ip.toString().c_str(), sizeof(server1IP));
+    server1 = server1IP;
+  }
+  if (DNSCache::resolve(host2, ip)) {
+    strlcpy(server2IP, ip.toString().c_str(), sizeof(server2IP));
+    server2 = server2IP;
+  }
+  configTzTime(rule.c_str(), server1, server2);
+  if (remember)
+    ClockDrift::setTimezone(rule.c_str(), zone, now);
 
+  // Wait for SNTP itself; getLocalTime() alone is satisfied by the system
+  // time carried over from the previous wake
   int attempts = 0;
-  display.rtcReset();
-
-  while (attempts++ < retries && !display.rtcIsSet()) {
+  while (attempts++ < retries) {
     Logger::logf(Logger::LOG_DEBUG, "Time sync attempt #%d...", attempts);
-    struct tm timeinfo;
-    if (getLocalTime(&timeinfo)) {
-      Logger::logf(Logger::LOG_DEBUG, "Time sync successful!");
-      delay(100);
-      time_t utcNow = time(NULL);
-      display.rtcSetEpoch(utcNow);
-      if (!display.rtcIsSet()) {
-        Logger::logf(Logger::LOG_ERROR, "Failed to set RTC!");
-      } else {
-        Logger::logf(Logger::LOG_INFO, "Sync: %s, epoch=%u",
-                     fmtEpoch(utcNow).c_str(), utcNow);
+    unsigned long start = millis();
+    while (millis() - start < 5000) {
+      if (sntp_get_sync_status() == SNTP_SYNC_STATUS_COMPLETED) {
+        Logger::logf(Logger::LOG_DEBUG, "Time sync successful!");
+        return ESP_OK;
       }
+      delay(100);
     }
     delay(1000);
   }
 
-  return display.rtcIsSet() ? ESP_OK : ESP_ERR_TIMEOUT;
+  // Don't keep pointing at servers that didn't answer
+  DNSCache::invalidate(host1);
+  DNSCache::invalidate(host2);
+  return ESP_ERR_TIMEOUT;
+}
+
+// Writes the synchronized system time to the RTC
+esp_err_t NTPCommit(Inkplate &display, esp_err_t fetchResult) {
+  // A failed sync says nothing about the RTC; keep a time it already has
+  if (fetchResult != ESP_OK) {
+    if (!display.rtcIsSet())
+      display.rtcReset();
+    return fetchResult;
+  }
+
+  // What the RTC had drifted to, for the drift model
+  struct timeval synced;
+  gettimeofday(&synced, nullptr);
+  time_t rtcBefore = display.rtcIsSet() ? display.rtcGetEpoch() : 0;
+
+  // Set the RTC on the next second boundary, so it starts in step with NTP
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  delay((1000000 - now.tv_usec) / 1000 + 1);
+  time_t utcNow = now.tv_sec + 1;
+
+  display.rtcReset();
+  display.rtcSetEpoch(utcNow);
+  if (!display.rtcIsSet()) {
+    Logger::logf(Logger::LOG_ERROR, "Failed to set RTC!");
+    return ESP_FAIL;
+  }
+  ClockDrift::recordSync(display, rtcBefore, synced, utcNow);
+
+  Logger::syncClock(utcNow);
+  Logger::logf(Logger::LOG_INFO, "Sync: %s, epoch=%u", fmtEpoch(utcNow).c_str(),
+               utcNow);
+  return ESP_OK;
+}
+
+// NTP sync function with timezone and retries
+esp_err_t NTPSync(Inkplate &display, const char *api,
+                  const AppConfig::Ntp &ntpConfig) {
+  return NTPCommit(display, NTPFetch(api, ntpConfig));
 }
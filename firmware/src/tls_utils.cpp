@@ -13,50 +13,27 @@
 
 #include "definitions.h"
 #include "logger.h"
+#include "power_profile.h"
 #include "psram_allocator.h"
 
 namespace {
 String gCACertPath = CA_CERT_FILE_PATH;
 bool gAllowInsecure = false;
-} // namespace
 
-bool TLSLoadCACert(const JsonVariant &config) {
-  gCACertPath = CA_CERT_FILE_PATH;
-  gAllowInsecure = false;
+// PEM bundle (PSRAM). WiFiClientSecure keeps a pointer to it and only parses
+// it when connecting, so it has to stay alive until sleep.
+char *gCACert = nullptr;
 
-  if (config.is<JsonObject>()) {
-    const char *path = config["security"]["caCertPath"] | CA_CERT_FILE_PATH;
-    gAllowInsecure = config["security"]["allowInsecure"] | false;
-    if (path && strlen(path) > 0)
-      gCACertPath = path;
-  }
-
-  if (!LittleFS.exists(gCACertPath)) {
-    Logger::logf(Logger::LOG_WARNING, "TLS CA file missing: %s. %s",
-                 gCACertPath.c_str(),
-                 gAllowInsecure ? "Insecure fallback enabled."
-                                : "HTTPS/TLS will fail closed.");
-    return false;
-  }
-  return true;
-}
+// Set when the bundle exists but was unusable; never fall back to insecure
+bool gCACertRejected = false;
 
-bool TLSConfigureClient(WiFiClientSecure &client) {
+// Reads and validates the CA bundle into gCACert
+bool loadCACert() {
   fs::File certFile = LittleFS.open(gCACertPath.c_str(), "r");
-
   if (!certFile || certFile.size() == 0) {
     if (certFile)
       certFile.close();
-    if (gAllowInsecure) {
-      client.setInsecure();
-      Logger::log(Logger::LOG_WARNING,
-                  "TLS CA missing/empty. Using insecure mode.");
-      return true;
-    } else {
-      Logger::log(Logger::LOG_ERROR,
-                  "TLS CA bundle missing/empty. Refusing insecure connection.");
-      return false;
-    }
+    return false;
   }
 
   size_t fileSize = certFile.size();
@@ -68,11 +45,12 @@ bool TLSConfigureClient(WiFiClientSecure &client) {
     Logger::log(Logger::LOG_ERROR,
                 "Please use the Cloudflare profile in tools/update_root_cas.mjs");
     certFile.close();
+    gCACertRejected = true;
     return false;
   }
 
-  // Use PSRAM for the temporary buffer to prevent Stack/Heap crash
-  // (StoreProhibited) We allocate 1 byte extra for null terminator
+  // Use PSRAM for the buffer to prevent Stack/Heap crash (StoreProhibited)
+  // We allocate 1 byte extra for null terminator
   char *buf = (char *)ps_malloc(fileSize + 1);
   if (!buf) {
     // Fallback to standard malloc if PSRAM isn't available
@@ -82,6 +60,7 @@ bool TLSConfigureClient(WiFiClientSecure &client) {
   if (!buf) {
     Logger::log(Logger::LOG_ERROR, "TLS CA Load failed: Out of Memory");
     certFile.close();
+    gCACertRejected = true;
     return false;
   }
 
@@ -95,18 +74,63 @@ bool TLSConfigureClient(WiFiClientSecure &client) {
     Logger::logf(Logger::LOG_ERROR, "TLS CA file is not valid PEM: %s",
                  gCACertPath.c_str());
     free(buf);
+    gCACertRejected = true;
     return false;
   }
 
-  // Configure Client
-  client.setCACert(buf);
+  gCACert = buf;
+  return true;
+}
+} // namespace
 
-  // Free memory immediately
-  free(buf);
+bool TLSLoadCACert(const AppConfig::Security &security) {
+  gCACertPath = CA_CERT_FILE_PATH;
+  gAllowInsecure = security.allowInsecure;
+  free(gCACert);
+  gCACert = nullptr;
+  gCACertRejected = false;
 
-  return true;
+  const char *path = security.caCertPath;
+  if (path && strlen(path) > 0)
+    gCACertPath = path;
+
+  if (!LittleFS.exists(gCACertPath)) {
+    Logger::logf(Logger::LOG_WARNING, "TLS CA file missing: %s. %s",
+                 gCACertPath.c_str(),
+                 gAllowInsecure ? "Insecure fallback enabled."
+                                : "HTTPS/TLS will fail closed.");
+    return false;
+  }
+  return loadCACert();
+}
+
+bool TLSConfigureClient(WiFiClientSecure &client) {
+  if (gCACert) {
+    client.setCACert(gCACert);
+    return true;
+  }
+
+  if (gAllowInsecure && !gCACertRejected) {
+    client.setInsecure();
+    Logger::log(Logger::LOG_WARNING,
+                "TLS CA missing/empty. Using insecure mode.");
+    return true;
+  }
+
+  Logger::log(Logger::LOG_ERROR,
+              "TLS CA bundle missing/empty. Refusing insecure connection.");
+  return false;
+}
+
+bool TLSConnect(WiFiClientSecure &client, const IPAddress &ip, uint16_t port,
+                const char *host) {
+  // The handshake's key exchange and certificate checks are CPU bound
+  PowerProfile::Boost boost;
+
+  // Passing the hostname keeps SNI and certificate name checks intact
+  return client.connect(ip, port, host, gCACert, nullptr, nullptr) == 1;
 }
 
 const char *TLSGetCACertPath() { return gCACertPath.c_str(); }
 
-bool TLSHasCACert() { return LittleFS.exists(gCACertPath); }
+bool TLSHasCACert() { return gCACert != nullptr; }
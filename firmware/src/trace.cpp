@@ -0,0 +1,288 @@
+#include "trace.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "logger.h"
+#else
+#include <chrono>
+#include <mutex>
+
+#define RTC_DATA_ATTR
+#endif
+
+namespace Trace {
+// One finished zone
+struct Event {
+  char name[TRACE_NAME_LEN];
+  uint32_t seq;      // Completion order (0 marks an empty slot)
+  uint16_t wake;     // Wake counter
+  uint8_t thread;    // Index into threadNames
+  uint8_t reserved;
+  uint32_t start;    // Microseconds since boot
+  uint32_t duration; // Microseconds
+  uint32_t heapIn, heapOut, heapMin;    // Free internal heap (bytes)
+  uint32_t psramIn, psramOut, psramMin; // Free PSRAM (bytes)
+};
+
+RTC_DATA_ATTR static uint16_t wakeCount = 0;
+RTC_DATA_ATTR static uint32_t lastSeq = 0;
+RTC_DATA_ATTR static Event ring[TRACE_RING_SIZE];
+RTC_DATA_ATTR static uint8_t ringHead = 0;
+RTC_DATA_ATTR static char threadNames[TRACE_MAX_THREADS][16];
+
+#ifdef ARDUINO
+// Newest zone published over MQTT
+RTC_DATA_ATTR static uint32_t exportedSeq = 0;
+
+// Zones also finish on the network worker tasks
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+#define TRACE_LOCK() portENTER_CRITICAL(&traceMux)
+#define TRACE_UNLOCK() portEXIT_CRITICAL(&traceMux)
+
+static uint32_t nowMicros() { return (uint32_t)esp_timer_get_time(); }
+static uint32_t freeHeap() {
+  return heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+}
+static uint32_t minHeap() {
+  return heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+}
+static uint32_t freePsram() {
+  return heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+static uint32_t minPsram() {
+  return heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+}
+static const char *threadName() { return pcTaskGetTaskName(nullptr); }
+#else
+static std::mutex traceMutex;
+#define TRACE_LOCK() traceMutex.lock()
+#define TRACE_UNLOCK() traceMutex.unlock()
+
+static uint32_t nowMicros() {
+  static const auto boot = std::chrono::steady_clock::now();
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - boot)
+      .count();
+}
+static uint32_t freeHeap() { return 0; }
+static uint32_t minHeap() { return 0; }
+static uint32_t freePsram() { return 0; }
+static uint32_t minPsram() { return 0; }
+static const char *threadName() { return "main"; }
+#endif
+
+// Index of a task in threadNames, adding it if new (call locked). Tasks
+// past TRACE_MAX_THREADS share the last row.
+static uint8_t threadIndex(const char *name) {
+  for (uint8_t i = 0; i < TRACE_MAX_THREADS; i++) {
+    if (!threadNames[i][0]) {
+      snprintf(threadNames[i], sizeof(threadNames[i]), "%s", name);
+      return i;
+    }
+    if (strcmp(threadNames[i], name) == 0)
+      return i;
+  }
+  return TRACE_MAX_THREADS - 1;
+}
+
+// Copy the zones completed after 'after' out of the ring, oldest first
+static size_t collect(Event *out, uint32_t after) {
+  size_t count = 0;
+  TRACE_LOCK();
+  for (int i = 0; i < TRACE_RING_SIZE; i++) {
+    const Event &e = ring[(ringHead + i) % TRACE_RING_SIZE];
+    if (e.seq > after)
+      out[count++] = e;
+  }
+  TRACE_UNLOCK();
+  return count;
+}
+
+// Formats trace events into a sink (a callable taking a buffer and length).
+// Names come from string literals and task names, so nothing is escaped.
+template <typename Sink> class Writer {
+public:
+  explicit Writer(Sink &sink) : _sink(sink) {}
+
+  // Append raw text
+  void raw(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    append(format, args);
+    va_end(args);
+  }
+
+  // Append one element of the traceEvents array
+  void event(const char *format, ...) {
+    if (!_first)
+      raw(",");
+    _first = false;
+
+    va_list args;
+    va_start(args, format);
+    append(format, args);
+    va_end(args);
+  }
+
+  size_t total() const { return _total; }
+
+private:
+  void append(const char *format, va_list args) {
+    char buffer[320];
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    if (len > 0)
+      _total += _sink(buffer, len < (int)sizeof(buffer) ? len
+                                                        : sizeof(buffer) - 1);
+  }
+
+  Sink &_sink;
+  size_t _total = 0;
+  bool _first = true;
+};
+
+// Write zones as a Chrome trace: one process per wake, one thread per task,
+// a complete ("X") event per zone and a counter track of free memory
+template <typename Sink>
+static size_t writeEvents(Sink &sink, const Event *events, size_t count) {
+  Writer<Sink> out(sink);
+  out.raw("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+  for (size_t i = 0; i < count; i++) {
+    const Event &e = events[i];
+
+    // Name each wake and task the first time it appears
+    bool wakeSeen = false, threadSeen = false;
+    for (size_t j = 0; j < i; j++) {
+      if (events[j].wake != e.wake)
+        continue;
+      wakeSeen = true;
+      threadSeen = threadSeen || events[j].thread == e.thread;
+    }
+    if (!wakeSeen)
+      out.event("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,"
+                "\"args\":{\"name\":\"wake %u\"}}",
+                e.wake, e.wake);
+    if (!threadSeen)
+      out.event("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,"
+                "\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                e.wake, e.thread, threadNames[e.thread]);
+
+    out.event("{\"name\":\"%s\",\"cat\":\"wake\",\"ph\":\"X\",\"pid\":%u,"
+              "\"tid\":%u,\"ts\":%u,\"dur\":%u,\"args\":{\"heap_in\":%u,"
+              "\"heap_out\":%u,\"heap_min\":%u,\"psram_in\":%u,"
+              "\"psram_out\":%u,\"psram_min\":%u}}",
+              e.name, e.wake, e.thread, e.start, e.duration, e.heapIn,
+              e.heapOut, e.heapMin, e.psramIn, e.psramOut, e.psramMin);
+    out.event("{\"name\":\"free\",\"ph\":\"C\",\"pid\":%u,\"ts\":%u,"
+              "\"args\":{\"heap\":%u,\"psram\":%u}}",
+              e.wake, e.start, e.heapIn, e.psramIn);
+    out.event("{\"name\":\"free\",\"ph\":\"C\",\"pid\":%u,\"ts\":%u,"
+              "\"args\":{\"heap\":%u,\"psram\":%u}}",
+              e.wake, e.start + e.duration, e.heapOut, e.psramOut);
+  }
+
+  out.raw("]}");
+  return out.total();
+}
+
+Zone::Zone(const char *name)
+    : _name(name), _start(nowMicros()), _heap(freeHeap()),
+      _psram(freePsram()) {}
+
+// Record the zone in the ring
+void Zone::end() {
+  if (!_name)
+    return;
+
+  Event e = {};
+  snprintf(e.name, sizeof(e.name), "%s", _name);
+  e.start = _start;
+  e.duration = nowMicros() - _start;
+  e.heapIn = _heap;
+  e.heapOut = freeHeap();
+  e.heapMin = minHeap();
+  e.psramIn = _psram;
+  e.psramOut = freePsram();
+  e.psramMin = minPsram();
+  const char *thread = threadName();
+
+  TRACE_LOCK();
+  e.wake = wakeCount;
+  e.thread = threadIndex(thread);
+  e.seq = ++lastSeq;
+  ring[ringHead] = e;
+  ringHead = (ringHead + 1) % TRACE_RING_SIZE;
+  TRACE_UNLOCK();
+
+  _name = nullptr;
+}
+
+// Start a new wake
+void begin() {
+  TRACE_LOCK();
+  wakeCount++;
+  TRACE_UNLOCK();
+}
+
+#ifdef ARDUINO
+// Write every zone in the ring as Chrome trace JSON
+size_t writeJson(Print &out) {
+  Event events[TRACE_RING_SIZE];
+  size_t count = collect(events, 0);
+  auto sink = [&out](const char *data, size_t len) {
+    return out.write((const uint8_t *)data, len);
+  };
+  return writeEvents(sink, events, count);
+}
+
+// Publish the zones that haven't been exported yet
+bool publish() {
+  TRACE_LOCK();
+  uint32_t after = exportedSeq;
+  TRACE_UNLOCK();
+
+  Event events[TRACE_RING_SIZE];
+  size_t count = collect(events, after);
+  if (count == 0)
+    return true;
+
+  bool published = Logger::publishStream("/trace", [&](Print &out) {
+    auto sink = [&out](const char *data, size_t len) {
+      return out.write((const uint8_t *)data, len);
+    };
+    writeEvents(sink, events, count);
+  });
+  if (!published) {
+    Logger::log(Logger::LOG_WARNING, "Trace: publish failed.");
+    return false;
+  }
+
+  // The ring is filled in completion order, so the last zone is the newest
+  TRACE_LOCK();
+  exportedSeq = events[count - 1].seq;
+  TRACE_UNLOCK();
+
+  Logger::logf(Logger::LOG_DEBUG, "Trace: published %u zones.", count);
+  return true;
+}
+#else
+// Write every zone in the ring as Chrome trace JSON
+size_t writeJson(FILE *out) {
+  Event events[TRACE_RING_SIZE];
+  size_t count = collect(events, 0);
+  auto sink = [out](const char *data, size_t len) {
+    return fwrite(data, 1, len, out);
+  };
+  return writeEvents(sink, events, count);
+}
+#endif
+} // namespace Trace
@@ -0,0 +1,136 @@
+// Inflater tests; run on the board (the ROM's tinfl is what's under test):
+//   pio test -e Debug -f test_inflater
+#include <Arduino.h>
+#include <stdarg.h>
+#include <unity.h>
+
+#include "../../src/inflater.cpp"
+
+// Logger stand-ins, so the test doesn't pull in the display and MQTT
+namespace Logger {
+void log(LogLevel level, const char *message) { Serial.println(message); }
+
+void logf(LogLevel level, const char *format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  Serial.println(buffer);
+}
+} // namespace Logger
+
+// gzip of expected() (Python's gzip.compress, mtime=0)
+static const uint8_t fixture[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0xd0,
+    0x3b, 0x4e, 0x42, 0x51, 0x14, 0x00, 0xc0, 0xde, 0x55, 0xbc, 0x25, 0xbc,
+    0xf3, 0xbb, 0xa8, 0xcb, 0xd1, 0x60, 0x24, 0x10, 0x88, 0x46, 0xa3, 0xcb,
+    0xb7, 0xb0, 0x66, 0xea, 0xe9, 0xe6, 0x72, 0xba, 0x1e, 0xb7, 0x7d, 0xdf,
+    0x9f, 0xb7, 0xaf, 0xf7, 0xe3, 0xf6, 0xf1, 0x7d, 0x7a, 0x3d, 0x6f, 0x2f,
+    0x9f, 0xb7, 0x9f, 0xeb, 0xf6, 0x76, 0xfb, 0x7d, 0xb8, 0xfc, 0x6b, 0x50,
+    0x93, 0x5a, 0xd4, 0xa6, 0x0e, 0x75, 0x51, 0x0f, 0xd4, 0x47, 0xea, 0x93,
+    0x34, 0x78, 0x15, 0xbc, 0x0a, 0x5e, 0x05, 0xaf, 0x82, 0x57, 0xc1, 0xab,
+    0xe0, 0x55, 0xf0, 0x2a, 0x78, 0x15, 0xbc, 0x4a, 0x5e, 0x25, 0xaf, 0x92,
+    0x57, 0xc9, 0xab, 0xe4, 0x55, 0xf2, 0x2a, 0x79, 0x95, 0xbc, 0x4a, 0x5e,
+    0x25, 0xaf, 0x8a, 0x57, 0xc5, 0xab, 0xe2, 0x55, 0xf1, 0xaa, 0x78, 0x55,
+    0xbc, 0x2a, 0x5e, 0x15, 0xaf, 0x8a, 0x57, 0xc5, 0xab, 0xe6, 0x55, 0xf3,
+    0xaa, 0x79, 0xd5, 0xbc, 0x6a, 0x5e, 0x35, 0xaf, 0x9a, 0x57, 0xcd, 0xab,
+    0xe6, 0x55, 0xf3, 0x6a, 0x78, 0x35, 0xbc, 0x1a, 0x5e, 0x0d, 0xaf, 0x86,
+    0x57, 0xc3, 0xab, 0xe1, 0xd5, 0xf0, 0x6a, 0x78, 0x35, 0xbc, 0x5a, 0xbc,
+    0x5a, 0xbc, 0x5a, 0xbc, 0x5a, 0x77, 0xae, 0xfe, 0x00, 0x8f, 0x0c, 0x29,
+    0x9e, 0x80, 0x07, 0x00, 0x00};
+
+// 64 lines of "line NNN: the quick brown fox"
+static String expected() {
+  String text;
+  char line[40];
+  for (int i = 0; i < 64; i++) {
+    snprintf(line, sizeof(line), "line %03d: the quick brown fox\n", i);
+    text += line;
+  }
+  return text;
+}
+
+// Check a finished inflate against expected()
+static void assertBody(Inflater &inflater, const PsramVector &out) {
+  String text = expected();
+  TEST_ASSERT_TRUE(inflater.finished());
+  TEST_ASSERT_EQUAL(text.length(), out.size());
+  TEST_ASSERT_EQUAL_MEMORY(text.c_str(), out.data(), out.size());
+}
+
+// The whole body in one write
+static void test_whole() {
+  Inflater inflater;
+  PsramVector out;
+  TEST_ASSERT_TRUE(inflater.begin(Inflater::Format::GZIP));
+  TEST_ASSERT_TRUE(inflater.write(fixture, sizeof(fixture), out));
+  assertBody(inflater, out);
+}
+
+// Two writes, split at every byte boundary. tinfl reads ahead near the end
+// of the deflate data, so the trailer can arrive split any which way.
+static void test_every_split() {
+  for (size_t split = 0; split <= sizeof(fixture); split++) {
+    Inflater inflater;
+    PsramVector out;
+    TEST_ASSERT_TRUE(inflater.begin(Inflater::Format::GZIP));
+    TEST_ASSERT_TRUE(inflater.write(fixture, split, out));
+    TEST_ASSERT_TRUE(
+        inflater.write(fixture + split, sizeof(fixture) - split, out));
+    assertBody(inflater, out);
+  }
+}
+
+// One byte per write
+static void test_bytewise() {
+  Inflater inflater;
+  PsramVector out;
+  TEST_ASSERT_TRUE(inflater.begin(Inflater::Format::GZIP));
+  for (size_t i = 0; i < sizeof(fixture); i++)
+    TEST_ASSERT_TRUE(inflater.write(fixture + i, 1, out));
+  assertBody(inflater, out);
+}
+
+// A wrong ISIZE fails the body
+static void test_bad_trailer() {
+  uint8_t corrupt[sizeof(fixture)];
+  memcpy(corrupt, fixture, sizeof(fixture));
+  corrupt[sizeof(corrupt) - 4] ^= 0x01;
+
+  Inflater inflater;
+  PsramVector out;
+  TEST_ASSERT_TRUE(inflater.begin(Inflater::Format::GZIP));
+  TEST_ASSERT_FALSE(inflater.write(corrupt, sizeof(corrupt), out));
+  TEST_ASSERT_FALSE(inflater.finished());
+}
+
+// Raw deflate whose first byte looks like a zlib CMF (method 8): a stored
+// block of "hello", then an empty final block. FCHECK tells them apart.
+static void test_raw_deflate_probe() {
+  static const uint8_t raw[] = {0x58, 0x05, 0x00, 0xfa, 0xff, 'h', 'e',
+                                'l',  'l',  'o',  0x03, 0x00};
+  for (size_t split = 0; split <= sizeof(raw); split++) {
+    Inflater inflater;
+    PsramVector out;
+    TEST_ASSERT_TRUE(inflater.begin(Inflater::Format::DEFLATE));
+    TEST_ASSERT_TRUE(inflater.write(raw, split, out));
+    TEST_ASSERT_TRUE(inflater.write(raw + split, sizeof(raw) - split, out));
+    TEST_ASSERT_TRUE(inflater.finished());
+    TEST_ASSERT_EQUAL(5, out.size());
+    TEST_ASSERT_EQUAL_MEMORY("hello", out.data(), 5);
+  }
+}
+
+void setup() {
+  delay(2000); // Let the serial monitor attach
+  UNITY_BEGIN();
+  RUN_TEST(test_whole);
+  RUN_TEST(test_every_split);
+  RUN_TEST(test_bytewise);
+  RUN_TEST(test_bad_trailer);
+  RUN_TEST(test_raw_deflate_probe);
+  UNITY_END();
+}
+
+void loop() {}
@@ -45,6 +45,31 @@ export function wsrv(img, mode) {
     return repl;
 }
 
+// Parse the device capability descriptor sent by the firmware
+// (X-Inky-Caps: "panel=inkplate10;bpp=3;pal=gray8;dec=jpeg,pjpeg;...")
+export function parseCaps(header) {
+    if (!header)
+        return undefined;
+
+    let caps = {};
+    for (let part of String(header).split(";")) {
+        let [key, value = ""] = part.split("=").map((s) => s.trim());
+        if (key)
+            caps[key] = /^\d+$/.test(value) ? parseInt(value) : value;
+    }
+    caps.dec = String(caps.dec ?? "jpeg").split(",").filter(Boolean);
+    return caps;
+}
+
+// Pick a cheaper JPEG quality when the device is low on battery or PSRAM
+export function capsQuality(caps) {
+    if (!caps)
+        return undefined;
+    if ((caps.batt ?? 100) <= 20 || (caps.psram ?? Infinity) < 1024 * 1024)
+        return 'low';
+    return undefined;
+}
+
 // Apply Cloudflare args to the image
 export function transform(mode, _headers = [], fit = "pad") {
     let top = _headers.some((h) => h.includes("X-Inky-Message-0")) ? mode.mbh : 0,
@@ -55,12 +80,13 @@ export function transform(mode, _headers = [], fit = "pad") {
         cf: {
             image: {
                 format: "baseline-jpeg",
-                quality: mode.q ?? 'medium-low', // Smaller images = faster rendering!
+                quality: mode.q ?? capsQuality(mode.caps) ?? 'medium-low', // Smaller images = faster rendering!
                 fit: _fit,
                 background: "#FFF", // Default to white for cleaner inkplate messages
                 width: mode.w,
                 height: mode.h - (_fit == "cover" ? (top + bottom) : 0),
-                saturation: 0, // Grayscale
+                // Grayscale, unless the device says it has a color panel
+                ...(String(mode.caps?.pal ?? "").startsWith("color") ? {} : { saturation: 0 }),
                 ...(mode.mbh > 0 ? {
                     border: {
                         color: "#FFF", // Default to white for cleaner inkplate messages
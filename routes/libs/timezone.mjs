@@ -5,12 +5,129 @@ export function getOffsetInSeconds(tz, date = new Date()) {
     return (tzd - utcd) / 1000;
 }
 
+// Offset (seconds) of a zone at an instant, to the second
+function offsetAt(formatter, ms) {
+    const p = Object.fromEntries(
+        formatter.formatToParts(new Date(ms)).map(x => [x.type, x.value])
+    );
+    const local = Date.UTC(+p.year, p.month - 1, +p.day, +p.hour % 24, +p.minute, +p.second);
+    return Math.round((local - Math.floor(ms / 1000) * 1000) / 1000);
+}
+
+// Format an offset as POSIX does: hours west of UTC, [+-]hh[:mm[:ss]]
+function posixOffset(offset) {
+    const west = -offset,
+        abs = Math.abs(west),
+        h = Math.floor(abs / 3600),
+        m = Math.floor(abs % 3600 / 60),
+        s = abs % 60;
+    let out = `${west < 0 ? '-' : ''}${h}`;
+    if (m || s)
+        out += `:${String(m).padStart(2, '0')}`;
+    if (s)
+        out += `:${String(s).padStart(2, '0')}`;
+    return out;
+}
+
+// Zone abbreviation at an instant, if POSIX can name it ("CET", not "GMT+1")
+function abbrevAt(tz, ms, fallback) {
+    for (const locale of ['en-GB', 'en-US']) {
+        const name = new Intl.DateTimeFormat(locale, { timeZone: tz, timeZoneName: 'short' })
+            .formatToParts(new Date(ms))
+            .find(p => p.type === 'timeZoneName')?.value || '';
+        if (/^[A-Za-z]{3,}$/.test(name))
+            return name;
+    }
+    return fallback;
+}
+
+// Transition rule "Mm.w.d[/time]" for an instant, in the local time it
+// happens at (the offset in effect before it)
+function posixRule(ms, offsetBefore) {
+    const local = new Date(ms + offsetBefore * 1000),
+        month = local.getUTCMonth(),
+        day = local.getUTCDate(),
+        daysInMonth = new Date(Date.UTC(local.getUTCFullYear(), month + 1, 0)).getUTCDate(),
+        week = day + 7 > daysInMonth ? 5 : Math.ceil(day / 7),
+        time = local.getUTCHours() * 3600 + local.getUTCMinutes() * 60 + local.getUTCSeconds();
+    let rule = `M${month + 1}.${week}.${local.getUTCDay()}`;
+    if (time !== 7200)
+        rule += `/${posixOffset(-time)}`;
+    return rule;
+}
+
+// Offset changes during a year, to the second
+function transitionsIn(formatter, year) {
+    const start = Date.UTC(year, 0, 1),
+        end = Date.UTC(year + 1, 0, 1),
+        step = 6 * 3600 * 1000;
+
+    // Scan in steps shorter than any DST period, then narrow each change down
+    const transitions = [];
+    let before = offsetAt(formatter, start);
+    for (let t = start + step; t <= end; t += step) {
+        const after = offsetAt(formatter, t);
+        if (after === before)
+            continue;
+
+        let lo = t - step, hi = t;
+        while (hi - lo > 1000) {
+            const mid = lo + Math.floor((hi - lo) / 2000) * 1000;
+            if (offsetAt(formatter, mid) === before)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        transitions.push({ at: hi, from: before, to: after });
+        before = after;
+    }
+    return transitions;
+}
+
+// DST rule for a year, or null if it has no yearly DST switch
+function dstRuleIn(tz, formatter, year) {
+    const transitions = transitionsIn(formatter, year);
+    if (transitions.length !== 2 || transitions[0].from !== transitions[1].to)
+        return null;
+
+    const [on, off] = transitions[0].to > transitions[0].from
+            ? transitions
+            : [transitions[1], transitions[0]],
+        std = on.from,
+        dst = on.to;
+    let posix = `${abbrevAt(tz, off.at, 'STD')}${posixOffset(std)}${abbrevAt(tz, on.at, 'DST')}`;
+    if (dst - std !== 3600)
+        posix += posixOffset(dst);
+    return `${posix},${posixRule(on.at, std)},${posixRule(off.at, dst)}`;
+}
+
+// Build a POSIX TZ rule for a zone ("PST8PDT,M3.2.0,M11.1.0"), so devices
+// can follow DST without asking again. The rule has to describe this year
+// and the next one alike; zones without DST, or whose transitions move
+// around (e.g. with Ramadan), get their current offset only.
+export function getPosixTZ(tz, date = new Date()) {
+    const formatter = new Intl.DateTimeFormat('en-US', {
+            timeZone: tz,
+            hourCycle: 'h23',
+            year: 'numeric', month: '2-digit', day: '2-digit',
+            hour: '2-digit', minute: '2-digit', second: '2-digit'
+        }),
+        year = date.getUTCFullYear(),
+        rule = dstRuleIn(tz, formatter, year);
+    if (rule && rule === dstRuleIn(tz, formatter, year + 1))
+        return rule;
+
+    const now = date.getTime();
+    return `${abbrevAt(tz, now, 'STD')}${posixOffset(offsetAt(formatter, now))}`;
+}
+
 // Get the timezone info
 export function getTimeZoneInfo(tz) {
     let result = {
         tz: 'UTC',
         gmtOffset: 0,
-        dst: 0
+        dst: 0,
+        posix: 'UTC0'
     };
 
     if (!tz)
@@ -44,9 +161,11 @@ export function getTimeZoneInfo(tz) {
             tz,
             gmtOffset: currentOffset,
             dst: (currentOffset > stdOffset) ? 1 : 0,
-            abbrev
+            abbrev,
+            posix: getPosixTZ(tz, now)
         };
     } catch (e) {
-        return { ...result, error: "Invalid timezone" };
+        const { posix, ...rest } = result;
+        return { ...rest, error: "Invalid timezone" };
     }
 }
\ No newline at end of file
@@ -9,7 +9,9 @@ import {
     getFallbackResponse,
     pickOne,
     b64png,
-    responseToReadableStream
+    responseToReadableStream,
+    parseCaps,
+    capsQuality
 } from '../providers/utils.mjs';
 
 // The AI slop system prompt
@@ -77,7 +79,8 @@ v1.get('/render/:providers?/:raw?', async (c) => {
             mbh: parseInt(c.req.query('mbh') ?? 0),
             fit: c.req.query('f') ?? c.req.query('fit') ?? undefined,
             q: c.req.query('q') ?? c.req.query('quality') ?? undefined,
-            transform: c.req.query('transform') !== "false"
+            transform: c.req.query('transform') !== "false",
+            caps: parseCaps(c.req.header('X-Inky-Caps')), // What the device can decode
         },
         _raw = c.req.param('raw') == "raw",
         _json = c.req.query('json') == "true",
@@ -94,14 +97,15 @@ v1.get('/render/:providers?/:raw?', async (c) => {
         if (!c?.env?.AI || !c?.env?.SLOP_IMAGE_MODEL || !c?.env?.SLOP_PROMPT_MODEL)
             return getFallbackResponse(_mode, "ai-slop");
 
-        // Build the endpoint
-        let _host = new URL(c.req.raw.url),
+        // Build the endpoint (caps is an object; it doesn't go in the query)
+        let { caps, ...params } = _mode,
+            _host = new URL(c.req.raw.url),
             cacheEverything = c.req.query('cache') == "false" ? false : true,
             endpoint = [
                 _host.origin,
                 "/api/v1/_internal/ai-slop/",
                 c.env.SLOP_ACCESS_TOKEN,
-                `?${new URLSearchParams(_mode).toString()}`
+                `?${new URLSearchParams(params).toString()}`
             ].join("");
 
         // To property transform we must make an API call to the internal AI slop endpoint
@@ -246,7 +250,7 @@ v1.get('/render/:providers?/:raw?', async (c) => {
                 // Take a screenshot
                 let screenshot = (await $target.screenshot(Object.assign({
                     type: "jpeg", // Always use jpeg
-                    quality: _mode.q ?? 50,
+                    quality: _mode.q ?? (capsQuality(_mode.caps) == 'low' ? 35 : 50),
                     omitBackground: true,
                     optimizeForSpeed: true,
                 }, (await provider?.options?.(_mode, c) ?? {}))));
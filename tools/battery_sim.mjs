@@ -0,0 +1,348 @@
+import { readFile } from 'node:fs/promises';
+import { existsSync } from 'node:fs';
+import { fileURLToPath } from 'node:url';
+import path from 'node:path';
+import { parseArgs } from 'node:util';
+
+class BatterySimulator {
+    static ROOT_DIR = path.resolve(path.dirname(fileURLToPath(import.meta.url)), '..');
+    static TRAITS_FILE = path.join(BatterySimulator.ROOT_DIR, 'firmware/include/board_traits.h');
+    static BOARDS = {
+        inkplate10: 'ARDUINO_INKPLATE10V2',
+        inkplate6color: 'ARDUINO_INKPLATECOLOR',
+    };
+
+    // Parse CLI args; the wake profile defaults describe a typical online wake
+    constructor() {
+        this.scriptName = path.basename(process.argv[1] ?? 'battery_sim.mjs');
+
+        const { values, positionals } = parseArgs({
+            args: process.argv.slice(2),
+            options: {
+                board: { type: 'string', short: 'b', default: 'inkplate10' },
+                capacity: { type: 'string' },
+                days: { type: 'string', default: '365' },
+                start: { type: 'string' },
+                awake: { type: 'string' },
+                radio: { type: 'string', default: '9000' },
+                refresh: { type: 'string' },
+                kb: { type: 'string', default: '150' },
+                cpu: { type: 'string', default: '240' },
+                log: { type: 'string' },
+                help: { type: 'boolean', short: 'h', default: false },
+            },
+            strict: true,
+            allowPositionals: true,
+        });
+
+        this.configFile = positionals[0] || 'config.json';
+        this.board = values.board;
+        this.capacity = values.capacity ? Number(values.capacity) : null;
+        this.days = Number(values.days);
+        this.start = values.start ? new Date(`${values.start}T00:00:00Z`) : new Date(Date.UTC(new Date().getFullYear(), 0, 1));
+        this.profile = {
+            radioMs: Number(values.radio),
+            refreshMs: values.refresh ? Number(values.refresh) : (this.board === 'inkplate6color' ? 30000 : 1600),
+            kb: Number(values.kb),
+            cpuMhz: Number(values.cpu),
+        };
+
+        // The radio is off before the refresh starts, so a wake lasts at
+        // least the two back to back
+        this.profile.awakeMs = Math.max(values.awake ? Number(values.awake) : 12000,
+            this.profile.radioMs + this.profile.refreshMs);
+        this.logFile = values.log;
+        this.help = values.help;
+    }
+
+    // Print CLI usage details and examples
+    usage() {
+        console.log(`Usage: ${this.scriptName} [config.json] [options]
+
+Replays the config's wake schedule over a simulated period and predicts
+battery life from the board's current model (firmware/include/board_traits.h).
+
+Options:
+  --board <name>     inkplate10 (default) or inkplate6color
+  --capacity <mAh>   Battery capacity (default: BOARD_BATTERY_MAH)
+  --days <n>         Days to simulate (default: 365)
+  --start <date>     First day, YYYY-MM-DD (default: Jan 1st this year)
+  --awake <ms>       Awake time per wake (default: 12000; never less than
+                     --radio plus --refresh)
+  --radio <ms>       WiFi on time per wake (default: 9000)
+  --refresh <ms>     Panel refresh time per wake (default: 1600, 6color: 30000)
+  --kb <n>           KB over WiFi per wake (default: 150)
+  --cpu <MHz>        Average CPU clock (default: 240)
+  --log <file>       Take the per-wake charge from "Energy:" log lines instead
+  --help             Show this help text
+
+Examples:
+  ${this.scriptName} config.json
+  ${this.scriptName} config_6color.json --board inkplate6color
+  ${this.scriptName} config.json --log mqtt.log`);
+    }
+
+    // Validates arguments and file existence
+    validate() {
+        if (!BatterySimulator.BOARDS[this.board]) {
+            console.error(`Error: Unknown board '${this.board}'.`);
+            process.exit(1);
+        }
+        if (!existsSync(this.configFile)) {
+            console.error(`Error: Config file '${this.configFile}' not found.`);
+            process.exit(1);
+        }
+        if (this.logFile && !existsSync(this.logFile)) {
+            console.error(`Error: Log file '${this.logFile}' not found.`);
+            process.exit(1);
+        }
+        if (!(this.days > 0) || Number.isNaN(this.start.getTime())) {
+            console.error('Error: --days and --start must be valid.');
+            process.exit(1);
+        }
+    }
+
+    // Evaluate board_traits.h for one board: just the #ifdef/#ifndef/#endif
+    // and #define lines it uses
+    async loadTraits() {
+        const source = await readFile(BatterySimulator.TRAITS_FILE, 'utf-8'),
+            defines = { [BatterySimulator.BOARDS[this.board]]: '1' },
+            stack = [];
+
+        for (const raw of source.split('\n')) {
+            const line = raw.trim(),
+                active = stack.every(Boolean);
+            let m;
+            if ((m = line.match(/^#ifdef\s+(\w+)/)))
+                stack.push(m[1] in defines);
+            else if ((m = line.match(/^#ifndef\s+(\w+)/)))
+                stack.push(!(m[1] in defines));
+            else if (line.startsWith('#endif'))
+                stack.pop();
+            else if (active && (m = line.match(/^#define\s+(\w+)\s*(.*)$/)))
+                defines[m[1]] = m[2];
+        }
+
+        const number = (name) => {
+            const value = Number.parseFloat(defines[name]);
+            if (Number.isNaN(value)) {
+                console.error(`Error: ${name} missing from board_traits.h.`);
+                process.exit(1);
+            }
+            return value;
+        };
+        return {
+            batteryMah: number('BOARD_BATTERY_MAH'),
+            sleepUa: number('BOARD_SLEEP_UA'),
+            cpuBaseMa: number('BOARD_CPU_BASE_MA'),
+            cpuMaPerMhz: number('BOARD_CPU_MA_PER_MHZ'),
+            radioMa: number('BOARD_RADIO_MA'),
+            refreshMa: number('BOARD_REFRESH_MA'),
+            uahPerKb: number('BOARD_UAH_PER_KB'),
+        };
+    }
+
+    // Average awake charge per wake (uAh) from "Energy:" log lines
+    async loadLog() {
+        const lines = (await readFile(this.logFile, 'utf-8')).split('\n'),
+            samples = lines
+                .map(line => line.match(/Energy: .*\buah=(\d+)\+\d+/))
+                .filter(Boolean)
+                .map(m => Number(m[1]));
+        if (!samples.length) {
+            console.error(`Error: No "Energy:" lines in '${this.logFile}'.`);
+            process.exit(1);
+        }
+        return { uah: samples.reduce((a, b) => a + b, 0) / samples.length, count: samples.length };
+    }
+
+    // Awake charge of one wake (uAh), the same sum Energy::finish() makes
+    wakeCharge(traits) {
+        const p = this.profile,
+            maMs = traits.cpuBaseMa * p.awakeMs + traits.cpuMaPerMhz * p.cpuMhz * p.awakeMs +
+                traits.radioMa * p.radioMs + traits.refreshMa * p.refreshMs;
+        return maMs / 3600 + traits.uahPerKb * p.kb;
+    }
+
+    // Duration string ("1h30m") to seconds, -1 if invalid (as parseDuration)
+    static parseDuration(str = '') {
+        const units = { w: 604800, d: 86400, h: 3600, m: 60, s: 1 };
+        let total = 0,
+            rest = String(str).trim();
+        while (rest.length) {
+            const m = rest.match(/^\s*(\d+)([wdhms])[^\d ]*/i);
+            if (!m)
+                return -1;
+            total += Number(m[1]) * units[m[2].toLowerCase()];
+            rest = rest.slice(m[0].length);
+        }
+        return total > 0 ? total : -1;
+    }
+
+    // Time of day ("7:30am", "22:15") to minutes since midnight, or null
+    static parseTime(str = '') {
+        const m = String(str).trim().toLowerCase().match(/^(\d{1,2}):(\d{2})\s*(am|pm)?$/);
+        if (!m)
+            return null;
+        let hour = Number(m[1]);
+        const minute = Number(m[2]);
+        if (m[3]) {
+            if (hour < 1 || hour > 12)
+                return null;
+            hour = (hour % 12) + (m[3] === 'pm' ? 12 : 0);
+        }
+        return hour < 24 && minute < 60 ? hour * 60 + minute : null;
+    }
+
+    // The schedule as calculateNextWake() sees it, without server hints
+    compileSchedule(config) {
+        const r = config.renderer ?? {},
+            start = BatterySimulator.parseTime(r.sleepwindow?.start),
+            stop = BatterySimulator.parseTime(r.sleepwindow?.stop);
+        return {
+            interval: BatterySimulator.parseDuration(r['wake-interval']),
+            sleepStart: start !== null && stop !== null ? start : -1,
+            sleepStop: start !== null && stop !== null ? stop : -1,
+            wakes: Object.keys(r.wakes ?? {})
+                .map(BatterySimulator.parseTime)
+                .filter(m => m !== null)
+                .sort((a, b) => a - b),
+            minRuntime: BatterySimulator.parseDuration(r.minruntime),
+        };
+    }
+
+    // Whether minutes since midnight fall in the sleep window
+    static inSleepWindow(minutes, s) {
+        if (s.sleepStart < 0)
+            return false;
+        if (s.sleepStart <= s.sleepStop)
+            return minutes >= s.sleepStart && minutes < s.sleepStop;
+        return minutes >= s.sleepStart || minutes < s.sleepStop;
+    }
+
+    // Next wake after 'now' (seconds, local time as UTC) as nextWake()
+    // works it out, interval wakes no closer than 'minInterval'
+    static nextWake(now, s, minInterval = 0) {
+        const dayStart = now - (now % 86400),
+            minuteOf = (t) => Math.floor((t % 86400) / 60);
+
+        let interval = s.interval > 0 ? now + s.interval : now - (now % 3600) + 3600;
+        interval = Math.max(interval, now + minInterval);
+
+        let candidate = interval,
+            scheduled = false;
+        if (s.wakes.length) {
+            const minute = minuteOf(now),
+                next = s.wakes.find(m => m > minute),
+                at = next !== undefined ? dayStart + next * 60 : dayStart + 86400 + s.wakes[0] * 60;
+            if (at <= interval) {
+                candidate = at;
+                scheduled = true;
+            }
+        }
+
+        if (s.sleepStart < 0)
+            return { at: candidate, scheduled };
+
+        // In (or landing in) the sleep window: wake at its end
+        const stopAfter = (t) => {
+            const stop = t - (t % 86400) + s.sleepStop * 60;
+            return stop <= t ? stop + 86400 : stop;
+        };
+        if (BatterySimulator.inSleepWindow(minuteOf(now), s))
+            return { at: stopAfter(now), scheduled: false };
+        if (BatterySimulator.inSleepWindow(minuteOf(candidate), s))
+            return { at: stopAfter(candidate), scheduled: false };
+        return { at: candidate, scheduled };
+    }
+
+    // Replay the schedule, draining the battery; recharge when it runs out
+    simulate(schedule, traits, wakeUah) {
+        const capacity = (this.capacity ?? traits.batteryMah) * 1000,
+            begin = Math.floor(this.start.getTime() / 1000),
+            end = begin + this.days * 86400,
+            stats = { wakes: 0, scheduled: 0, stretched: 0, charges: [], used: 0 };
+
+        let now = begin,
+            charge = capacity,
+            chargedAt = begin,
+            perWake = wakeUah;
+        while (now < end) {
+            // The battery budget, with the true cost of a wake known
+            let minInterval = 0;
+            if (schedule.minRuntime > 0 && now < chargedAt + schedule.minRuntime) {
+                const days = (chargedAt + schedule.minRuntime - now) / 86400,
+                    spare = charge / perWake / days - schedule.wakes.length;
+                minInterval = spare <= 1 ? 86400 : Math.floor(86400 / spare);
+            }
+
+            const wake = BatterySimulator.nextWake(now, schedule, minInterval),
+                sleepUah = traits.sleepUa * (wake.at - now) / 3600,
+                used = wakeUah + sleepUah;
+            if (minInterval && wake.at !== BatterySimulator.nextWake(now, schedule).at)
+                stats.stretched++;
+
+            // Wake cost with the sleep before it, as the firmware measures it
+            perWake = used;
+            charge -= used;
+            stats.used += used;
+            now = wake.at;
+            stats.wakes++;
+            if (wake.scheduled)
+                stats.scheduled++;
+
+            if (charge <= 0) {
+                stats.charges.push((now - chargedAt) / 86400);
+                charge = capacity;
+                chargedAt = now;
+            }
+        }
+        stats.remaining = charge / capacity;
+        stats.partial = (now - chargedAt) / 86400;
+        return stats;
+    }
+
+    // Main execution flow
+    async execute() {
+        if (this.help) {
+            this.usage();
+            return;
+        }
+        this.validate();
+
+        let config;
+        try {
+            config = JSON.parse(await readFile(this.configFile, 'utf-8'));
+        } catch (e) {
+            console.error(`Error parsing JSON from '${this.configFile}': ${e.message}`);
+            process.exit(1);
+        }
+
+        const traits = await this.loadTraits(),
+            schedule = this.compileSchedule(config),
+            logged = this.logFile ? await this.loadLog() : null,
+            wakeUah = logged ? logged.uah : this.wakeCharge(traits),
+            stats = this.simulate(schedule, traits, wakeUah),
+            capacity = this.capacity ?? traits.batteryMah,
+            perDay = stats.used / 1000 / this.days;
+
+        console.log(`Board: ${this.board} (${capacity} mAh, sleep ${traits.sleepUa} uA)`);
+        console.log(logged
+            ? `Wake charge: ${wakeUah.toFixed(1)} uAh (average of ${logged.count} logged wakes)`
+            : `Wake charge: ${wakeUah.toFixed(1)} uAh (model: ${this.profile.awakeMs}ms awake, ${this.profile.radioMs}ms WiFi, ${this.profile.refreshMs}ms refresh, ${this.profile.kb}KB, ${this.profile.cpuMhz}MHz)`);
+        console.log(`Simulated: ${this.days} days, ${stats.wakes} wakes (${(stats.wakes / this.days).toFixed(1)}/day, ${stats.scheduled} scheduled)`);
+        if (schedule.minRuntime > 0)
+            console.log(`Battery budget: ${stats.stretched} interval wakes stretched for minruntime`);
+        console.log(`Usage: ${perDay.toFixed(2)} mAh/day`);
+
+        // A full charge lasts capacity / usage; simulated charges show where
+        // the budget or the schedule bends that
+        const life = stats.charges.length
+            ? stats.charges.reduce((a, b) => a + b, 0) / stats.charges.length
+            : capacity / perDay;
+        console.log(`Battery life: ${life.toFixed(1)} days per charge (${stats.charges.length} charges in the period, ${(stats.remaining * 100).toFixed(0)}% left at the end)`);
+    }
+}
+
+// Instantiate and run the simulator
+new BatterySimulator().execute();